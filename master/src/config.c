@@ -25,6 +25,8 @@ master_config_t* cargar_config(char* config_path) {
         master_config->algoritmo_planificacion = ALGORITHM_FIFO;
     } else if (string_equals_ignore_case(algoritmo, "PRIORIDADES")) {
         master_config->algoritmo_planificacion = ALGORITHM_PRIORIDADES;
+    } else if (string_equals_ignore_case(algoritmo, "EDF")) {
+        master_config->algoritmo_planificacion = ALGORITHM_EDF;
     } else {
         printf("[WARNING] Algoritmo desconocido '%s', usando FIFO por defecto\n", algoritmo);
         master_config->algoritmo_planificacion = ALGORITHM_FIFO;
@@ -33,6 +35,58 @@ master_config_t* cargar_config(char* config_path) {
     master_config->tiempo_aging = config_has_property(config, "TIEMPO_AGING") ? 
                                  config_get_int_value(config, "TIEMPO_AGING") : 0;
 
+    // Detección de Workers caídos: un Worker que anunció CAPACIDAD_HEARTBEAT y deja de contestar
+    // se da por caído tras INTERVALO_HEARTBEAT * (MAX_HEARTBEATS_PERDIDOS + 1) ms y su Query vuelve a READY
+    master_config->intervalo_heartbeat = config_has_property(config, "INTERVALO_HEARTBEAT") ?
+                                        config_get_int_value(config, "INTERVALO_HEARTBEAT") : 1000;
+    master_config->max_heartbeats_perdidos = config_has_property(config, "MAX_HEARTBEATS_PERDIDOS") ?
+                                            config_get_int_value(config, "MAX_HEARTBEATS_PERDIDOS") : 3;
+    if (master_config->max_heartbeats_perdidos <= 0) {
+        // Con 0 cualquier Worker quedaría caído en el primer tick
+        printf("[WARNING] MAX_HEARTBEATS_PERDIDOS debe ser mayor a 0 (%d), usando 3 por defecto\n",
+               master_config->max_heartbeats_perdidos);
+        master_config->max_heartbeats_perdidos = 3;
+    }
+    // Para Workers sin heartbeats la caída del host se detecta por keepalive/TCP_USER_TIMEOUT:
+    // al vencer se deja de asignarle queries y la suya se finaliza con error (no hay un PC reciente)
+    master_config->tcp_user_timeout = config_has_property(config, "TCP_USER_TIMEOUT") ?
+                                     config_get_int_value(config, "TCP_USER_TIMEOUT") : TCP_USER_TIMEOUT_DEFAULT_MS;
+    master_config->timeout_desalojo = config_has_property(config, "TIMEOUT_DESALOJO") ?
+                                     config_get_int_value(config, "TIMEOUT_DESALOJO") : 0;
+
+    // Control de admisión de NEW_QUERY (los topes en 0 dejan READY sin límite)
+    master_config->max_queries_ready = config_has_property(config, "MAX_QUERIES_READY") ?
+                                      config_get_int_value(config, "MAX_QUERIES_READY") : 0;
+    master_config->max_queries_por_banda = config_has_property(config, "MAX_QUERIES_POR_BANDA") ?
+                                          config_get_int_value(config, "MAX_QUERIES_POR_BANDA") : 0;
+    master_config->ancho_banda_prioridad = config_has_property(config, "ANCHO_BANDA_PRIORIDAD") ?
+                                          config_get_int_value(config, "ANCHO_BANDA_PRIORIDAD") : 1;
+    if (master_config->ancho_banda_prioridad <= 0) {
+        master_config->ancho_banda_prioridad = 1;
+    }
+
+    char* politica = config_has_property(config, "POLITICA_ADMISION") ?
+                    config_get_string_value(config, "POLITICA_ADMISION") : "RECHAZAR";
+
+    if (string_equals_ignore_case(politica, "RECHAZAR")) {
+        master_config->politica_admision = ADMISION_RECHAZAR;
+    } else if (string_equals_ignore_case(politica, "BACKPRESSURE")) {
+        master_config->politica_admision = ADMISION_BACKPRESSURE;
+    } else {
+        printf("[WARNING] Política de admisión desconocida '%s', usando RECHAZAR por defecto\n", politica);
+        master_config->politica_admision = ADMISION_RECHAZAR;
+    }
+
+    master_config->retry_after_admision = config_has_property(config, "RETRY_AFTER_ADMISION") ?
+                                         config_get_int_value(config, "RETRY_AFTER_ADMISION") : 1000;
+    master_config->intervalo_metricas = config_has_property(config, "INTERVALO_METRICAS") ?
+                                       config_get_int_value(config, "INTERVALO_METRICAS") : 0;
+
+    char* path_queries = config_has_property(config, "PATH_QUERIES") ?
+                        config_get_string_value(config, "PATH_QUERIES") : "";
+    strncpy(master_config->path_queries, path_queries, MAX_PATH_SIZE - 1);
+    master_config->path_queries[MAX_PATH_SIZE - 1] = '\0';
+
     char* log_level_str = config_has_property(config, "LOG_LEVEL") ? 
                          config_get_string_value(config, "LOG_LEVEL") : "INFO";
     strncpy(master_config->log_level, log_level_str, 31);
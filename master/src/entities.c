@@ -1,27 +1,152 @@
 #include "master.h"
 
+// ========== POOL DE QUERIES ==========
+// Las queries se reservan en slabs de QUERIES_POR_SLAB registros contiguos y se
+// reciclan por una free list, así miles de queries en READY no quedan dispersas
+// por el heap. Los paths se internan: cada script distinto se guarda una sola vez
+// con un contador de referencias. El pool vive en master->pool_queries y tiene su
+// propio mutex porque las queries se crean y destruyen con main_mutex tomado y sin él.
+
+#define QUERIES_POR_SLAB 1024
+
+typedef union slot_query {
+    query_t query;
+    union slot_query* siguiente_libre;
+} slot_query_t;
+
+typedef struct {
+    char* path;
+    int referencias;
+} path_internado_t;
+
+void query_pool_iniciar(pool_queries_t* pool) {
+    pthread_mutex_init(&pool->mutex, NULL);
+    pool->slabs = list_create();
+    pool->libres = NULL;
+    pool->paths = dictionary_create();
+}
+
+static slot_query_t* reservar_slot(pool_queries_t* pool) {
+    // ⚠️ Llamar con pool->mutex tomado
+    if (!pool->libres) {
+        slot_query_t* slab = malloc(sizeof(slot_query_t) * QUERIES_POR_SLAB);
+        if (!slab) return NULL;
+
+        list_add(pool->slabs, slab);
+
+        for (int i = QUERIES_POR_SLAB - 1; i >= 0; i--) {
+            slab[i].siguiente_libre = pool->libres;
+            pool->libres = &slab[i];
+        }
+    }
+
+    slot_query_t* slot = pool->libres;
+    pool->libres = slot->siguiente_libre;
+    return slot;
+}
+
+static void devolver_slot(pool_queries_t* pool, slot_query_t* slot) {
+    // ⚠️ Llamar con pool->mutex tomado. El estado queda en QUERY_LIBRE: siguiente_libre
+    // solo pisa el id, así query_destruir detecta un slot devuelto dos veces
+    slot->query.state = QUERY_LIBRE;
+    slot->siguiente_libre = pool->libres;
+    pool->libres = slot;
+}
+
+static const char* internar_path(pool_queries_t* pool, char* path) {
+    // ⚠️ Llamar con pool->mutex tomado
+    path_internado_t* entrada = dictionary_get(pool->paths, path);
+    if (!entrada) {
+        entrada = malloc(sizeof(path_internado_t));
+        if (!entrada) return NULL;
+        entrada->path = strdup(path);
+        entrada->referencias = 0;
+        dictionary_put(pool->paths, path, entrada);
+    }
+
+    entrada->referencias++;
+    return entrada->path;
+}
+
+static void liberar_path_internado(path_internado_t* entrada) {
+    free(entrada->path);
+    free(entrada);
+}
+
+static void soltar_path(pool_queries_t* pool, const char* path) {
+    // ⚠️ Llamar con pool->mutex tomado
+    if (!path) return;
+
+    path_internado_t* entrada = dictionary_get(pool->paths, (char*)path);
+    if (entrada && --entrada->referencias == 0) {
+        dictionary_remove_and_destroy(pool->paths, (char*)path, (void*)liberar_path_internado);
+    }
+}
+
+/**
+ * @brief Libera los slabs y la tabla de paths
+ *
+ * Libera también las queries que sigan vivas (en READY o EXEC): todas son memoria
+ * del pool, así que al cerrar el Master no hace falta destruirlas una por una.
+ */
+void query_pool_destruir(pool_queries_t* pool) {
+    list_destroy_and_destroy_elements(pool->slabs, free);
+    pool->slabs = NULL;
+    pool->libres = NULL;
+    dictionary_destroy_and_destroy_elements(pool->paths, (void*)liberar_path_internado);
+    pool->paths = NULL;
+    pthread_mutex_destroy(&pool->mutex);
+}
+
 // ========== FUNCIONES DE QUERY ==========
 
-query_t* query_crear(uint64_t id, char* path, int priority, int qc_socket) {
-    query_t* query = malloc(sizeof(query_t));
-    if (!query) return NULL;
+query_t* query_crear(master_t* master, uint64_t id, char* path, int priority, int qc_socket) {
+    if (!master || !path) return NULL;
 
+    pool_queries_t* pool = &master->pool_queries;
+    pthread_mutex_lock(&pool->mutex);
+    slot_query_t* slot = reservar_slot(pool);
+    const char* path_internado = slot ? internar_path(pool, path) : NULL;
+    if (slot && !path_internado) {
+        devolver_slot(pool, slot);
+        slot = NULL;
+    }
+    pthread_mutex_unlock(&pool->mutex);
+    if (!slot) return NULL;
+
+    query_t* query = &slot->query;
     query->id = id;
-    strncpy(query->path_query, path, MAX_PATH_SIZE - 1);
-    query->path_query[MAX_PATH_SIZE - 1] = '\0';
+    query->path_query = path_internado;
     query->priority = priority;
     query->priority_original = priority;
     query->state = QUERY_NEW;
     query->pc = 0;
     query->qc_socket = qc_socket;
-    memset(query->worker_id, 0, MAX_WORKER_ID_SIZE);
+    query->deadline = 0;
+    query->costo_estimado = 0;
+    query->script = NULL;
 
     return query;
 }
 
-void query_destruir(query_t* query) {
-    if (!query) return;
-    free(query);
+void query_destruir(master_t* master, query_t* query) {
+    if (!master || !query) return;
+
+    pool_queries_t* pool = &master->pool_queries;
+    pthread_mutex_lock(&pool->mutex);
+    if (query->state == QUERY_LIBRE) {
+        // Doble destrucción: devolver el slot otra vez cerraría un ciclo en la free list
+        // y dos queries nuevas compartirían el mismo registro
+        log_error(master->logger, "[MASTER] Query destruida dos veces (slot %p)", (void*)query);
+        abort();
+    }
+    script_cacheado_t* script = query->script;
+    soltar_path(pool, query->path_query);
+    devolver_slot(pool, (slot_query_t*)query);
+    pthread_mutex_unlock(&pool->mutex);
+
+    // Fuera del mutex del pool: la caché de scripts tiene el suyo
+    if (script) cache_scripts_soltar(master, script);
 }
 
 // ========== FUNCIONES DE WORKER ==========
@@ -35,6 +160,14 @@ worker_t* worker_crear(char* id, int socket) {
     worker->socket = socket;
     worker->status = WORKER_IDLE;
     worker->current_query_id = 0;
+    worker->heartbeats_pendientes = 0;
+    worker->primer_hb_pendiente_ms = 0;
+    worker->pc_query_id = 0;
+    worker->pc_recibido_ms = 0;
+    worker->caido = false;
+    worker->reencolar_query = false;
+    worker->capacidades = 0;
+    worker->scripts = dictionary_create();
 
     return worker;
 }
@@ -45,6 +178,7 @@ void worker_destruir(worker_t* worker) {
     // NOTA: El socket NO se cierra aquí porque es manejado por el hilo de conexión
     // Cerrar el socket aquí causaría un doble cierre y podría afectar otras conexiones
     
+    dictionary_destroy(worker->scripts);
     free(worker);
 }
 
@@ -52,16 +186,27 @@ worker_t* buscar_worker_por_id(master_t* master, char* worker_id) {
     if (!master || !worker_id) return NULL;
 
     pthread_mutex_lock(&master->main_mutex);
-    
+    worker_t* worker = buscar_worker_por_id_directo(master, worker_id);
+    pthread_mutex_unlock(&master->main_mutex);
+    return worker;
+}
+
+/**
+ * @brief Igual que buscar_worker_por_id pero sin tomar el mutex
+ * 
+ * ⚠️ PRECONDICIÓN CRÍTICA: Esta función DEBE ser llamada con master->main_mutex YA TOMADO
+ * (main_mutex no es recursivo: buscar_worker_por_id con el mutex tomado se bloquea).
+ */
+worker_t* buscar_worker_por_id_directo(master_t* master, char* worker_id) {
+    if (!master || !worker_id) return NULL;
+
     for (int i = 0; i < list_size(master->workers); i++) {
         worker_t* worker = (worker_t*)list_get(master->workers, i);
         if (worker && strcmp(worker->id, worker_id) == 0) {
-            pthread_mutex_unlock(&master->main_mutex);
             return worker;
         }
     }
     
-    pthread_mutex_unlock(&master->main_mutex);
     return NULL;
 }
 
@@ -80,10 +225,11 @@ worker_t* buscar_worker_por_id(master_t* master, char* worker_id) {
 worker_t* buscar_worker_libre(master_t* master) {
     if (!master) return NULL;
 
-    // Iterar sobre workers sin tomar mutex (el caller debe tenerlo tomado)
+    // Iterar sobre workers sin tomar mutex (el caller debe tenerlo tomado).
+    // Un worker caído ya tiene el socket con shutdown: no se le asigna nada aunque siga en la lista
     for (int i = 0; i < list_size(master->workers); i++) {
         worker_t* worker = (worker_t*)list_get(master->workers, i);
-        if (worker && worker->status == WORKER_IDLE) {
+        if (worker && !worker->caido && worker->status == WORKER_IDLE) {
             return worker;
         }
     }
@@ -105,7 +251,7 @@ int contar_workers_disponibles(master_t* master) {
     int count = 0;
     for (int i = 0; i < list_size(master->workers); i++) {
         worker_t* worker = (worker_t*)list_get(master->workers, i);
-        if (worker && worker->status == WORKER_IDLE) {
+        if (worker && !worker->caido && worker->status == WORKER_IDLE) {
             count++;
         }
     }
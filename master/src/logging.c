@@ -132,6 +132,7 @@ const char* query_state_to_string(query_state_t state) {
         case QUERY_CANCELING: return "CANCELING";
         case QUERY_EXIT: return "EXIT";
         case QUERY_ERROR: return "ERROR";
+        case QUERY_LIBRE: return "LIBRE";
         default: return "UNKNOWN";
     }
 }
@@ -149,6 +150,7 @@ const char* algorithm_to_string(scheduling_algorithm_t algorithm) {
     switch (algorithm) {
         case ALGORITHM_FIFO: return "FIFO";
         case ALGORITHM_PRIORIDADES: return "PRIORIDADES";
+        case ALGORITHM_EDF: return "EDF";
         default: return "UNKNOWN";
     }
 }
@@ -166,6 +168,35 @@ void log_current_status(t_log* logger, master_t* master) {
              worker_count, ready_count, exec_count);
 }
 
+// ========== MÉTRICAS ==========
+
+void log_metricas(master_t* master) {
+    if (!master || !master->logger) return;
+
+    pthread_mutex_lock(&master->main_mutex);
+    master_metricas_t metricas = master->metricas;
+    int ready_count = queue_size(master->ready_queue);
+    pthread_mutex_unlock(&master->main_mutex);
+
+    log_info(master->logger, "[METRICAS] Queries admitidas: %lu, rechazadas: %lu, demoradas por backpressure: %lu, en READY: %d",
+             metricas.queries_admitidas, metricas.queries_rechazadas, metricas.queries_demoradas, ready_count);
+    log_info(master->logger, "[METRICAS] Deadlines cumplidos: %lu, incumplidos: %lu",
+             metricas.deadlines_cumplidos, metricas.deadlines_incumplidos);
+}
+
+static void timer_metricas(void* arg) {
+    master_t* master = (master_t*)arg;
+    if (!master->running) return;
+    log_metricas(master);
+}
+
+void programar_metricas(master_t* master) {
+    if (!master || master->config->intervalo_metricas <= 0) return;
+
+    timer_programar(master->timers, master->config->intervalo_metricas, master->config->intervalo_metricas,
+                    timer_metricas, master, false);
+}
+
 t_log_level log_level_from_string(char* level) {
     if (!level) return LOG_LEVEL_INFO;
     
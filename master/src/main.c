@@ -4,13 +4,22 @@
 // Variable global para el master (para manejo de señales)
 master_t* global_master = NULL;
 
-// Manejador de señales para shutdown graceful
+// Manejador de señales para shutdown graceful.
+// Solo usa funciones async-signal-safe: marca el cierre y despierta al accept();
+// el hilo principal hace el resto (master_detener + master_destruir) al volver de master_iniciar.
 void signal_handler(int sig) {
+    (void)sig;
+    static const char mensaje[] = "\n[MASTER] Señal recibida. Cerrando servidor...\n";
+    if (write(STDOUT_FILENO, mensaje, sizeof(mensaje) - 1) < 0) {
+        // Nada que hacer: el cierre sigue igual
+    }
+
     if (global_master) {
-        printf("\n[MASTER] Señal %d recibida. Cerrando servidor...\n", sig);
-        master_detener(global_master);
+        global_master->running = false;
+        if (global_master->server_socket > 0) {
+            shutdown(global_master->server_socket, SHUT_RDWR);
+        }
     }
-    exit(0);
 }
 
 int main(int argc, char* argv[]) {
@@ -33,16 +42,17 @@ int main(int argc, char* argv[]) {
 
     printf("[MASTER] Iniciando servidor en puerto %d...\n", global_master->config->puerto_escucha);
     printf("[MASTER] Algoritmo de planificación: %s\n", 
-           global_master->config->algoritmo_planificacion == ALGORITHM_FIFO ? "FIFO" : "PRIORIDADES");
+           algorithm_to_string(global_master->config->algoritmo_planificacion));
     
     if (global_master->config->tiempo_aging > 0) {
         printf("[MASTER] Aging habilitado cada %d ms\n", global_master->config->tiempo_aging);
     }
 
-    // Iniciar el servidor
+    // Iniciar el servidor (vuelve cuando una señal pide el cierre)
     master_iniciar(global_master);
 
-    // Cleanup
+    // Detener hilos y cleanup
+    master_detener(global_master);
     master_destruir(global_master);
     
     return 0;
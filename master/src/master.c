@@ -1,4 +1,5 @@
 #include "master.h"
+#include <errno.h>
 
 // Estructura para pasar datos a los hilos de conexión
 typedef struct {
@@ -39,12 +40,41 @@ master_t* master_crear(char* config_path) {
     master->pending_cancellations = dictionary_create();
     master->workers = list_create();
     master->query_controls = list_create();
+    master->conexiones = list_create();
+    query_pool_iniciar(&master->pool_queries);
+    cache_scripts_iniciar(master);
 
     // Inicializar mutex principal
     pthread_mutex_init(&master->main_mutex, NULL);
+    pthread_cond_init(&master->cupo_ready, NULL);
+    pthread_cond_init(&master->sin_conexiones, NULL);
+
+    // Rueda de timers (la thread arranca en master_iniciar)
+    master->timers = timer_wheel_crear();
+    if (!master->timers) {
+        log_error(master->logger, "[MASTER] Error creando la rueda de timers");
+        pthread_cond_destroy(&master->cupo_ready);
+        pthread_cond_destroy(&master->sin_conexiones);
+        pthread_mutex_destroy(&master->main_mutex);
+        list_destroy(master->conexiones);
+        query_pool_destruir(&master->pool_queries);
+        queue_destroy(master->ready_queue);
+        dictionary_destroy(master->exec_map);
+        dictionary_destroy(master->pending_preemptions);
+        dictionary_destroy(master->pending_cancellations);
+        list_destroy(master->workers);
+        list_destroy(master->query_controls);
+        cache_scripts_destruir(master);
+        log_destroy(master->logger);
+        master_config_destruir(master->config);
+        free(master);
+        return NULL;
+    }
+    master->next_heartbeat_seq = 0;
 
     // Inicializar contadores
     master->worker_count = 0;
+    memset(&master->metricas, 0, sizeof(master_metricas_t));
     master->running = false;
 
     log_info(master->logger, "[MASTER] Master inicializado correctamente");
@@ -62,13 +92,20 @@ void master_destruir(master_t* master) {
         master_detener(master);
     }
 
-    // Destruir estructuras de datos
+    // Métricas finales en el camino normal de salida (no desde el manejador de señales)
+    log_metricas(master);
+
+    // Destruir timers antes que las estructuras que usan sus callbacks
+    timer_wheel_destruir(master->timers);
+
+    // Destruir estructuras de datos. Las queries que contienen son memoria de
+    // master->pool_queries y se liberan con el pool más abajo
     if (master->ready_queue) {
-        queue_destroy_and_destroy_elements(master->ready_queue, (void*)query_destruir);
+        queue_destroy(master->ready_queue);
     }
     
     if (master->exec_map) {
-        dictionary_destroy_and_destroy_elements(master->exec_map, (void*)query_destruir);
+        dictionary_destroy(master->exec_map);
     }
     
     // NOTA: pending_preemptions y pending_cancellations contienen REFERENCIAS a queries
@@ -89,7 +126,16 @@ void master_destruir(master_t* master) {
         list_destroy_and_destroy_elements(master->query_controls, (void*)query_control_destruir);
     }
 
+    // Liberar slabs (con las queries que quedaban) y paths internados
+    query_pool_destruir(&master->pool_queries);
+    cache_scripts_destruir(master);
+
+    // master_detener ya esperó a los hilos de conexión: nadie más usa las condiciones
+    list_destroy_and_destroy_elements(master->conexiones, free);
+
     // Destruir mutex
+    pthread_cond_destroy(&master->cupo_ready);
+    pthread_cond_destroy(&master->sin_conexiones);
     pthread_mutex_destroy(&master->main_mutex);
 
     // Cerrar socket
@@ -103,7 +149,7 @@ void master_destruir(master_t* master) {
     free(master);
 }
 
-int configurar_socket_servidor(int port) {
+int configurar_socket_servidor(int port, int tcp_user_timeout) {
     int server_socket = socket(AF_INET, SOCK_STREAM, 0);
     if (server_socket < 0) {
         perror("Error creando socket");
@@ -118,6 +164,12 @@ int configurar_socket_servidor(int port) {
         return -1;
     }
 
+    // Keepalive y TCP_USER_TIMEOUT: Linux los hereda en cada socket aceptado, así un Worker
+    // cuyo host desaparece se detecta en segundos aunque no conteste heartbeats
+    if (configurar_keepalive(server_socket, tcp_user_timeout) < 0) {
+        perror("Error configurando keepalive");
+    }
+
     struct sockaddr_in server_addr;
     memset(&server_addr, 0, sizeof(server_addr));
     server_addr.sin_family = AF_INET;
@@ -150,10 +202,17 @@ void* manejar_conexion(void* arg) {
     while (master->running) {
         op_code codigo;
         int size;
+        errno = 0;
         void* payload = recibir_payload(client_socket, &codigo, &size);
+        int error_recv = errno;
         
         if (!payload && size == 0) {
             log_info(master->logger, "[MASTER] Cliente desconectado (socket %d)", client_socket);
+            // Keepalive/TCP_USER_TIMEOUT vencido: el host del Worker dejó de responder, no
+            // cerró la conexión. Se lo marca caído para no asignarle nada mientras se desconecta
+            if (error_recv == ETIMEDOUT || error_recv == EHOSTUNREACH || error_recv == ENETUNREACH) {
+                marcar_worker_inalcanzable(master, client_socket, error_recv);
+            }
             // Manejar desconexión
             manejar_desconexion_cliente(master, client_socket);
             break;
@@ -172,6 +231,8 @@ void* manejar_conexion(void* arg) {
             case QUERY_FINISHED:
             case READ_RESULT:
             case CANCEL_QUERY:  // Respuesta del worker tras cancelación (reutiliza PREEMPTION_ACK)
+            case HEARTBEAT_ACK:
+            case SCRIPT_FALTANTE:
                 manejar_mensaje_worker(master, client_socket, codigo, payload, size);
                 break;
             default:
@@ -183,15 +244,43 @@ void* manejar_conexion(void* arg) {
         if (payload) free(payload);
     }
 
-    close(client_socket);
+    desregistrar_conexion(master, client_socket);
     return NULL;
 }
 
+/**
+ * @brief Cierra el socket de una conexión y la saca de master->conexiones
+ *
+ * Lo llama el propio hilo de conexión al terminar. Cuando no queda ninguna,
+ * despierta a master_detener.
+ */
+void desregistrar_conexion(master_t* master, int client_socket) {
+    pthread_mutex_lock(&master->main_mutex);
+
+    for (int i = 0; i < list_size(master->conexiones); i++) {
+        int* socket_registrado = (int*)list_get(master->conexiones, i);
+        if (*socket_registrado == client_socket) {
+            list_remove(master->conexiones, i);
+            free(socket_registrado);
+            break;
+        }
+    }
+
+    // Se cierra con el mutex tomado para que master_detener no haga shutdown de un fd reutilizado
+    close(client_socket);
+
+    if (list_is_empty(master->conexiones)) {
+        pthread_cond_broadcast(&master->sin_conexiones);
+    }
+
+    pthread_mutex_unlock(&master->main_mutex);
+}
+
 void master_iniciar(master_t* master) {
     if (!master) return;
 
     // Configurar socket del servidor
-    master->server_socket = configurar_socket_servidor(master->config->puerto_escucha);
+    master->server_socket = configurar_socket_servidor(master->config->puerto_escucha, master->config->tcp_user_timeout);
     if (master->server_socket < 0) {
         log_error(master->logger, "[MASTER] Error configurando servidor");
         return;
@@ -200,11 +289,13 @@ void master_iniciar(master_t* master) {
     master->running = true;
     log_info(master->logger, "[MASTER] Servidor iniciado en puerto %d", master->config->puerto_escucha);
 
-    // Iniciar hilo de aging si está habilitado
-    if (master->config->tiempo_aging > 0) {
-        if (pthread_create(&master->aging_thread, NULL, funcion_hilo_aging, master) != 0) {
-            log_warning(master->logger, "[MASTER] Error creando hilo aging");
-        }
+    // Aging, heartbeats y timeouts de desalojo corren en la thread de la rueda de timers
+    if (!timer_wheel_iniciar(master->timers)) {
+        log_warning(master->logger, "[MASTER] Error creando hilo de timers");
+    } else {
+        programar_aging(master);
+        programar_heartbeats(master);
+        programar_metricas(master);
     }
 
     // Loop principal - aceptar conexiones
@@ -220,6 +311,19 @@ void master_iniciar(master_t* master) {
             continue;
         }
 
+        // Registrar la conexión para que master_detener pueda cortarla y esperar su hilo
+        int* socket_registrado = malloc(sizeof(int));
+        *socket_registrado = client_socket;
+        pthread_mutex_lock(&master->main_mutex);
+        if (!master->running) {
+            pthread_mutex_unlock(&master->main_mutex);
+            free(socket_registrado);
+            close(client_socket);
+            break;
+        }
+        list_add(master->conexiones, socket_registrado);
+        pthread_mutex_unlock(&master->main_mutex);
+
         // Crear hilo para manejar la conexión
         connection_data_t* conn_data = malloc(sizeof(connection_data_t));
         conn_data->master = master;
@@ -228,30 +332,54 @@ void master_iniciar(master_t* master) {
         pthread_t connection_thread;
         if (pthread_create(&connection_thread, NULL, manejar_conexion, conn_data) != 0) {
             log_error(master->logger, "[MASTER] Error creando hilo para conexión");
-            close(client_socket);
             free(conn_data);
+            desregistrar_conexion(master, client_socket);
         } else {
             pthread_detach(connection_thread);
         }
     }
 }
 
+/**
+ * @brief Detiene el servidor y espera a que terminen todos los hilos
+ *
+ * Se llama desde el hilo principal cuando master_iniciar vuelve (nunca desde un
+ * manejador de señales: toma main_mutex y espera a otros hilos). Al volver, ningún
+ * hilo de conexión ni de timers sigue vivo y master_destruir puede liberar todo.
+ */
 void master_detener(master_t* master) {
-    if (!master || !master->running) return;
+    if (!master) return;
 
     log_info(master->logger, "[MASTER] Deteniendo servidor...");
+
+    pthread_mutex_lock(&master->main_mutex);
     master->running = false;
 
+    // Despertar a los Query Control que esperan cupo en READY (con el mutex, para no perder la señal)
+    pthread_cond_broadcast(&master->cupo_ready);
+
+    // Cortar las conexiones abiertas: sus hilos salen del recv y terminan por el camino de desconexión
+    for (int i = 0; i < list_size(master->conexiones); i++) {
+        int* socket_registrado = (int*)list_get(master->conexiones, i);
+        shutdown(*socket_registrado, SHUT_RDWR);
+    }
+    pthread_mutex_unlock(&master->main_mutex);
+
     // Cerrar socket para salir del accept()
     if (master->server_socket > 0) {
         close(master->server_socket);
         master->server_socket = -1;
     }
 
-    // Esperar a que termine el hilo de aging
-    if (master->config->tiempo_aging > 0 && master->aging_thread) {
-        pthread_join(master->aging_thread, NULL);
+    // Esperar a que termine el hilo de timers
+    timer_wheel_detener(master->timers);
+
+    // Esperar a los hilos de conexión (son detached, cada uno se desregistra al salir)
+    pthread_mutex_lock(&master->main_mutex);
+    while (!list_is_empty(master->conexiones)) {
+        pthread_cond_wait(&master->sin_conexiones, &master->main_mutex);
     }
+    pthread_mutex_unlock(&master->main_mutex);
 }
 
 uint64_t generar_id_query(master_t* master) {
@@ -290,8 +418,9 @@ void manejar_desconexion_worker(master_t* master, worker_t* worker) {
     
     pthread_mutex_lock(&master->main_mutex);
     
-    // Si el worker tenía una query asignada, finalizarla con error
-    if (worker->current_query_id != 0) {
+    // Si el worker tenía una query asignada, finalizarla con error (o reencolarla si el Master
+    // lo dio por caído). Se busca en exec_map porque el ID 0 es una query válida
+    if (dictionary_has_key(master->exec_map, worker->id)) {
         query_t* affected_query = (query_t*)dictionary_get(master->exec_map, worker->id);
         if (affected_query) {
             affected_query_id = affected_query->id;
@@ -299,20 +428,32 @@ void manejar_desconexion_worker(master_t* master, worker_t* worker) {
             // Log del desalojo por desconexión
             log_desalojo_por_desconexion(master->logger, affected_query->id, affected_query->priority, worker->id);
             
-            // Notificar al Query Control sobre el error usando utils
-            int error_size = 0;
-            void* error_payload = serializar_ack_con_id(affected_query->id, &error_size);
-            if (enviar_paquete(affected_query->qc_socket, ERROR, error_payload, error_size) != 0) {
-                log_warning(master->logger, "[MASTER] Error enviando ERROR al Query Control (query %lu), posiblemente desconectado", 
-                           affected_query->id);
-            }
-            free(error_payload);
-            
             // Remover la query del exec_map
             dictionary_remove(master->exec_map, worker->id);
             
-            // Destruir la query
-            query_destruir(affected_query);
+            bool cancelando = dictionary_get(master->pending_cancellations, worker->id) == affected_query;
+            if (cancelando) {
+                // Su Query Control ya se desconectó: la libera el bloque de pending_cancellations
+            } else if (worker->reencolar_query && worker->pc_query_id == affected_query->id) {
+                // El Master dio al worker por caído con un PC reciente: la Query no falló,
+                // vuelve a READY y se reanuda desde ese PC en otro worker
+                affected_query->state = QUERY_READY;
+                queue_push(master->ready_queue, affected_query);
+                log_info(master->logger, "[MASTER] Query %lu reencolada en READY (PC=%u) tras caída del worker %s",
+                         affected_query->id, affected_query->pc, worker->id);
+            } else {
+                // Notificar al Query Control sobre el error usando utils
+                int error_size = 0;
+                void* error_payload = serializar_ack_con_id(affected_query->id, &error_size);
+                if (enviar_paquete(affected_query->qc_socket, ERROR, error_payload, error_size) != 0) {
+                    log_warning(master->logger, "[MASTER] Error enviando ERROR al Query Control (query %lu), posiblemente desconectado", 
+                               affected_query->id);
+                }
+                free(error_payload);
+                
+                // Destruir la query
+                query_destruir(master, affected_query);
+            }
         }
     }
     
@@ -339,7 +480,7 @@ void manejar_desconexion_worker(master_t* master, worker_t* worker) {
         // Finalizar la query cancelada
         canceling_query->state = QUERY_EXIT;
         dictionary_remove(master->pending_cancellations, worker->id);
-        query_destruir(canceling_query);
+        query_destruir(master, canceling_query);
     }
     
     // Log de desconexión del worker
@@ -358,12 +499,120 @@ void manejar_desconexion_worker(master_t* master, worker_t* worker) {
     planificar_siguiente_query(master);
 }
 
+// ========== SUPERVISIÓN DE WORKERS ==========
+
+/**
+ * @brief Indica si el último PC que mandó el worker sirve para reanudar su Query
+ *
+ * ⚠️ PRECONDICIÓN: llamar con master->main_mutex tomado.
+ *
+ * El PC llega en HEARTBEAT_ACK y es fresco si es de la Query que el worker tiene en
+ * ejecución y llegó a lo sumo un intervalo de heartbeat antes de que el worker dejara
+ * de contestar. Reanudar desde un PC más viejo repetiría CREATE/TAG/COMMIT que ya
+ * llegaron al Storage. Aun así puede repetirse hasta un intervalo de instrucciones.
+ */
+static bool pc_fresco(master_t* master, worker_t* worker) {
+    if (!(worker->capacidades & CAPACIDAD_HEARTBEAT) || worker->pc_recibido_ms == 0) return false;
+
+    query_t* query = (query_t*)dictionary_get(master->exec_map, worker->id);
+    if (!query || query->id != worker->pc_query_id) return false;
+
+    uint64_t silencio_desde = worker->heartbeats_pendientes > 0 ? worker->primer_hb_pendiente_ms : tiempo_actual_ms();
+    return silencio_desde <= worker->pc_recibido_ms + (uint64_t)master->config->intervalo_heartbeat;
+}
+
+/**
+ * @brief Da a un worker por caído y fuerza el cierre de su conexión
+ *
+ * ⚠️ PRECONDICIÓN: llamar con master->main_mutex tomado.
+ *
+ * El shutdown() despierta al hilo de conexión del worker (recv devuelve 0), que
+ * sigue el camino normal de manejar_desconexion_worker. Si el worker había mandado
+ * un PC fresco su Query se reencola; si no, se finaliza con error como pide el enunciado.
+ */
+void declarar_worker_caido(master_t* master, worker_t* worker, const char* motivo) {
+    if (!master || !worker || worker->caido) return;
+
+    worker->caido = true;
+    worker->reencolar_query = pc_fresco(master, worker);
+    log_warning(master->logger, "[MASTER] Worker %s dado por caído (%s), cerrando su conexión", worker->id, motivo);
+    shutdown(worker->socket, SHUT_RDWR);
+}
+
+/**
+ * @brief Marca como caído al worker de un socket cuya conexión venció por timeout
+ *
+ * Se llama desde el hilo de conexión SIN mutex tomado, antes de manejar la desconexión.
+ * Solo evita que se le asigne algo más: keepalive/TCP_USER_TIMEOUT vencen mucho después
+ * del último PC conocido, así que la Query se finaliza con error como en un cierre normal.
+ */
+void marcar_worker_inalcanzable(master_t* master, int socket, int error) {
+    worker_t* worker = buscar_worker_por_socket(master, socket);
+    if (!worker) return;
+
+    pthread_mutex_lock(&master->main_mutex);
+    if (!worker->caido) {
+        worker->caido = true;
+        log_warning(master->logger, "[MASTER] Worker %s inalcanzable (%s)", worker->id, strerror(error));
+    }
+    pthread_mutex_unlock(&master->main_mutex);
+}
+
+static void timer_heartbeat(void* arg) {
+    master_t* master = (master_t*)arg;
+    if (!master->running) return;
+
+    pthread_mutex_lock(&master->main_mutex);
+
+    uint64_t seq = master->next_heartbeat_seq++;
+    int hb_size = 0;
+    void* hb_payload = serializar_ack_con_id(seq, &hb_size);
+
+    for (int i = 0; i < list_size(master->workers); i++) {
+        worker_t* worker = (worker_t*)list_get(master->workers, i);
+        // Solo a workers que anunciaron CAPACIDAD_HEARTBEAT: a los viejos sería un op_code
+        // desconocido por segundo, y quedan cubiertos por keepalive/TCP_USER_TIMEOUT
+        if (!worker || worker->caido || !(worker->capacidades & CAPACIDAD_HEARTBEAT)) continue;
+
+        if (worker->heartbeats_pendientes >= master->config->max_heartbeats_perdidos) {
+            declarar_worker_caido(master, worker, "sin respuesta a heartbeats");
+            continue;
+        }
+
+        if (worker->heartbeats_pendientes == 0) {
+            worker->primer_hb_pendiente_ms = tiempo_actual_ms();
+        }
+        worker->heartbeats_pendientes++;
+        if (enviar_paquete(worker->socket, HEARTBEAT, hb_payload, hb_size) != 0) {
+            log_debug(master->logger, "[MASTER] Error enviando HEARTBEAT al worker %s", worker->id);
+        }
+    }
+
+    free(hb_payload);
+    pthread_mutex_unlock(&master->main_mutex);
+}
+
+void programar_heartbeats(master_t* master) {
+    if (!master) return;
+
+    if (master->config->intervalo_heartbeat <= 0) {
+        log_info(master->logger, "[MASTER] Heartbeats a Workers deshabilitados");
+        return;
+    }
+
+    timer_programar(master->timers, master->config->intervalo_heartbeat, master->config->intervalo_heartbeat,
+                    timer_heartbeat, master, false);
+    log_info(master->logger, "[MASTER] Heartbeats a Workers cada %d ms (máximo %d sin respuesta)",
+             master->config->intervalo_heartbeat, master->config->max_heartbeats_perdidos);
+}
+
 void manejar_desconexion_query_control(master_t* master, query_control_t* qc) {
     if (!master || !qc) return;
     
     if (qc->connected_query_id != 0) {
         uint64_t query_id = qc->connected_query_id;
         query_t* query_to_cancel = NULL;
+        bool esperando_cancelacion = false;  // La query queda en pending_cancellations hasta el ack
         
         pthread_mutex_lock(&master->main_mutex);
         
@@ -406,7 +655,9 @@ void manejar_desconexion_query_control(master_t* master, query_control_t* qc) {
                         log_info(master->logger, "[MASTER] Solicitud de cancelación enviada al worker %s para query %lu", 
                                  worker->id, query_id);
                         // NO remover de exec_map ni marcar worker como IDLE aquí
-                        // Eso se hará cuando el worker responda con el PC
+                        // Eso se hará cuando el worker responda con el PC, y la query la destruye
+                        // completar_cancelacion_query (o la desconexión del worker)
+                        esperando_cancelacion = true;
                     } else {
                         log_error(master->logger, "[MASTER] Error enviando cancelación al worker %s", worker->id);
                         
@@ -449,18 +700,24 @@ void manejar_desconexion_query_control(master_t* master, query_control_t* qc) {
             }
             
             list_destroy(temp_list);
+            
+            if (query_to_cancel) {
+                pthread_cond_broadcast(&master->cupo_ready);
+            }
         }
         
         if (query_to_cancel) {
+            // Log de desconexión
+            log_query_control_disconnect(master->logger, query_id, query_to_cancel->priority, master->worker_count);
+        }
+        
+        if (query_to_cancel && !esperando_cancelacion) {
             // Según enunciado: "En el caso de que la Query se encuentre en READY, 
             // la misma se deberá enviar a EXIT directamente"
             query_to_cancel->state = QUERY_EXIT;
             
-            // Log de desconexión
-            log_query_control_disconnect(master->logger, query_id, query_to_cancel->priority, master->worker_count);
-            
             // Destruir la query cancelada
-            query_destruir(query_to_cancel);
+            query_destruir(master, query_to_cancel);
         }
         
         // Remover query control de la lista
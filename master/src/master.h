@@ -9,6 +9,8 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <sys/stat.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #define sleep_ms(ms) usleep((ms)*1000)
@@ -31,6 +33,10 @@
 #define MAX_PATH_SIZE 256
 #define MAX_WORKER_ID_SIZE 32
 
+// Rueda de timers: resolución de un tick y cantidad de slots (una vuelta = 2.56 s)
+#define TIMER_TICK_MS 10
+#define TIMER_WHEEL_SLOTS 256
+
 // Estados de Query
 typedef enum {
     QUERY_NEW,
@@ -38,7 +44,8 @@ typedef enum {
     QUERY_EXEC,
     QUERY_CANCELING,  // Query está siendo cancelada (esperando contexto del worker)
     QUERY_EXIT,
-    QUERY_ERROR
+    QUERY_ERROR,
+    QUERY_LIBRE       // Slot del pool sin query (ya destruida)
 } query_state_t;
 
 // Estados de Worker
@@ -51,22 +58,36 @@ typedef enum {
 // Algoritmos de planificación
 typedef enum {
     ALGORITHM_FIFO,
-    ALGORITHM_PRIORIDADES
+    ALGORITHM_PRIORIDADES,
+    ALGORITHM_EDF           // Earliest Deadline First con deadlines enviados por el Query Control
 } scheduling_algorithm_t;
 
+// Qué hacer con una NEW_QUERY cuando READY no tiene cupo
+typedef enum {
+    ADMISION_RECHAZAR,      // Responder QUERY_RECHAZADA con un retry-after
+    ADMISION_BACKPRESSURE   // Dejar de leer de ese Query Control hasta que haya cupo
+} politica_admision_t;
+
 // Usar op_code de utils/src/comunicacion.h para los tipos de mensaje
 // Los tipos están definidos en utils/src/comunicacion.h
 
 // Estructura de Query
+// Los campos que recorre el planificador van primero; el resto solo se usa al despachar.
+// Las queries salen de master->pool_queries (slabs, ver entities.c) y path_query apunta
+// a una tabla de paths internados compartida por todas las queries del mismo script.
+// No hay split hot/cold en un array aparte: READY es un t_queue de query_t* que se
+// recorre nodo a nodo, así que el salto por elemento quedaría igual.
 typedef struct {
     uint64_t id;
-    char path_query[MAX_PATH_SIZE];
     int priority;
     int priority_original;
+    uint64_t deadline;      // ms absolutos de tiempo_actual_ms() (0 = sin deadline)
+    int costo_estimado;     // ms estimados por el Query Control (0 = desconocido)
     query_state_t state;
     uint32_t pc;
     int qc_socket;
-    char worker_id[MAX_WORKER_ID_SIZE];
+    const char* path_query; // Internado: no modificar ni liberar
+    struct script_cacheado* script; // Versión del script fijada al admitirla (NULL = no está en caché)
 } query_t;
 
 // Estructura de Worker
@@ -75,6 +96,14 @@ typedef struct {
     int socket;
     worker_state_t status;
     uint64_t current_query_id;
+    int heartbeats_pendientes;  // HEARTBEAT enviados sin HEARTBEAT_ACK
+    uint64_t primer_hb_pendiente_ms; // Envío del más viejo de esos HEARTBEAT
+    uint64_t pc_query_id;       // Query del último PC recibido en HEARTBEAT_ACK
+    uint64_t pc_recibido_ms;    // Cuándo llegó ese PC (0 = nunca)
+    bool caido;                 // Dado por caído: no se le asigna nada más
+    bool reencolar_query;       // Caído con PC fresco: su Query vuelve a READY en vez de terminar con ERROR
+    int capacidades;            // CAPACIDAD_* anunciadas en el handshake (0 = Worker viejo)
+    t_dictionary* scripts;      // hash -> NULL, scripts que el Worker ya tiene
 } worker_t;
 
 // Estructura de Query Control
@@ -88,9 +117,75 @@ typedef struct {
     int puerto_escucha;
     scheduling_algorithm_t algoritmo_planificacion;
     int tiempo_aging;
+    int intervalo_heartbeat;      // ms entre HEARTBEAT a Workers con CAPACIDAD_HEARTBEAT (0 = deshabilitado)
+    int max_heartbeats_perdidos;  // HEARTBEAT sin respuesta antes de dar al Worker por caído
+    int tcp_user_timeout;         // ms, keepalive/TCP_USER_TIMEOUT para detectar hosts de Workers caídos
+    int timeout_desalojo;         // ms máximos esperando PREEMPTION_ACK (0 = sin límite)
+    int max_queries_ready;        // Tope de queries en READY (0 = sin tope)
+    int max_queries_por_banda;    // Tope de queries en READY por banda de prioridad (0 = sin tope)
+    int ancho_banda_prioridad;    // Cantidad de niveles de prioridad que agrupa cada banda
+    politica_admision_t politica_admision;
+    int retry_after_admision;     // ms sugeridos al Query Control rechazado
+    int intervalo_metricas;       // ms entre logs de métricas (0 = solo al cerrar)
+    char path_queries[MAX_PATH_SIZE]; // Scripts que el Master envía inline ("" = solo el path)
     char log_level[32];
 } master_config_t;
 
+// Contadores exportados por log (protegidos por main_mutex)
+typedef struct {
+    uint64_t queries_admitidas;
+    uint64_t queries_rechazadas;
+    uint64_t queries_demoradas;   // Esperaron cupo bajo ADMISION_BACKPRESSURE
+    uint64_t deadlines_cumplidos;
+    uint64_t deadlines_incumplidos;
+} master_metricas_t;
+
+// Pool de queries por slabs y tabla de paths internados (ver entities.c)
+typedef struct {
+    pthread_mutex_t mutex;      // Propio: las queries se crean y destruyen con y sin main_mutex
+    t_list* slabs;              // union slot_query[QUERIES_POR_SLAB]
+    union slot_query* libres;   // Free list de slots
+    t_dictionary* paths;        // path -> path_internado_t*
+} pool_queries_t;
+
+// Script en la caché del Master, direccionado por el MD5 de su contenido.
+// Lo referencian las queries que lo fijaron y el path del que es la versión actual
+typedef struct script_cacheado {
+    char hash[HASH_SCRIPT_SIZE];
+    void* contenido;
+    int size;
+    int referencias;
+} script_cacheado_t;
+
+// Versión en disco del script de un path: si cambian mtime o tamaño se vuelve a leer
+typedef struct {
+    char hash[HASH_SCRIPT_SIZE];
+    struct timespec mtime;
+    off_t size;
+} script_en_disco_t;
+
+// Timer de la rueda. Los periódicos se reprograman solos; los one-shot se liberan al disparar
+typedef void (*timer_callback_t)(void* arg);
+
+typedef struct timer_entry {
+    uint64_t vencimiento;       // Tick absoluto en el que dispara
+    uint32_t periodo_ticks;     // 0 = one-shot
+    timer_callback_t callback;
+    void* arg;
+    bool liberar_arg;           // free(arg) cuando el timer deja de existir
+    struct timer_entry* siguiente;
+} timer_entry_t;
+
+// Rueda de timers (hashed timing wheel) movida por un timerfd desde una única thread
+typedef struct {
+    int timerfd;
+    uint64_t tick_actual;
+    timer_entry_t* slots[TIMER_WHEEL_SLOTS];
+    pthread_mutex_t mutex;
+    pthread_t thread;
+    bool activa;
+} timer_wheel_t;
+
 // Estructura principal del Master
 typedef struct {
     master_config_t* config;
@@ -107,33 +202,31 @@ typedef struct {
     t_dictionary* pending_cancellations; // worker_id -> query_t* (query siendo cancelada)
     t_list* workers;
     t_list* query_controls;
+    pool_queries_t pool_queries;     // Dueño de todos los query_t
+    pthread_mutex_t scripts_mutex;   // Protege scripts_por_hash, hash_por_path y las referencias
+    t_dictionary* scripts_por_hash;  // hash -> script_cacheado_t*
+    t_dictionary* hash_por_path;     // path -> script_en_disco_t*, se rehashea solo si el archivo cambió
     
     // Mutex principal (para simplificar y evitar deadlocks)
     pthread_mutex_t main_mutex;
+    pthread_cond_t cupo_ready;  // Se señaliza cuando sale una query de ready_queue
+    pthread_cond_t sin_conexiones;  // Se señaliza cuando termina el último hilo de conexión
+    t_list* conexiones;         // int* socket de cada hilo de conexión vivo
     
     // Socket del servidor
     int server_socket;
     
     // Control de hilos
     bool running;
-    pthread_t aging_thread;
+    timer_wheel_t* timers;  // Aging, heartbeats y timeouts de desalojo
+    uint64_t next_heartbeat_seq;
     
     // Contadores para logging
     int worker_count;
+    master_metricas_t metricas;
     
 } master_t;
 
-// Estructura simplificada para datos de mensaje (no incluye op_code que va separado)
-typedef struct {
-    uint64_t query_id;
-    char path[MAX_PATH_SIZE];
-    int priority;
-    uint32_t pc;
-    char worker_id[MAX_WORKER_ID_SIZE];
-    char data[MAX_BUFFER_SIZE];
-    char reason[256];
-} message_data_t;
-
 // Funciones principales
 master_t* master_crear(char* config_path);
 void master_destruir(master_t* master);
@@ -145,14 +238,25 @@ master_config_t* cargar_config(char* config_path);
 void master_config_destruir(master_config_t* config);
 
 // Funciones de Query
-query_t* query_crear(uint64_t id, char* path, int priority, int qc_socket);
-void query_destruir(query_t* query);
+query_t* query_crear(master_t* master, uint64_t id, char* path, int priority, int qc_socket);
+void query_destruir(master_t* master, query_t* query);
+void query_pool_iniciar(pool_queries_t* pool);
+void query_pool_destruir(pool_queries_t* pool);
+
+// Caché de scripts (scripts.c)
+void cache_scripts_iniciar(master_t* master);
+script_cacheado_t* cache_scripts_cargar(master_t* master, const char* path);
+void cache_scripts_soltar(master_t* master, script_cacheado_t* script);
+void cache_scripts_destruir(master_t* master);
+void* armar_execute_query(master_t* master, worker_t* worker, query_t* query, char hash_inline[HASH_SCRIPT_SIZE], int* size);
+void registrar_script_enviado(master_t* master, char* worker_id, const char* hash);
 uint64_t generar_id_query(master_t* master);
 
 // Funciones de Worker
 worker_t* worker_crear(char* id, int socket);
 void worker_destruir(worker_t* worker);
 worker_t* buscar_worker_por_id(master_t* master, char* worker_id);
+worker_t* buscar_worker_por_id_directo(master_t* master, char* worker_id);
 worker_t* buscar_worker_libre(master_t* master);
 int contar_workers_disponibles(master_t* master);  // ⚠️ Llamar con mutex tomado
 int contar_workers_totales(master_t* master);     // ⚠️ Llamar con mutex tomado
@@ -167,20 +271,39 @@ void planificar_query(master_t* master, query_t* query);
 void planificar_siguiente_query(master_t* master);
 void asignar_query_a_worker(master_t* master, query_t* query, worker_t* worker);
 query_t* obtener_query_mayor_prioridad(master_t* master);
+bool query_precede(master_t* master, query_t* a, query_t* b);
 void aplicar_aging(master_t* master);
-void* funcion_hilo_aging(void* arg);
+void programar_aging(master_t* master);
+
+// Funciones de control de admisión
+bool hay_cupo_en_ready(master_t* master, int priority);  // ⚠️ Llamar con mutex tomado
+bool admitir_query(master_t* master, int qc_socket, int priority);
 
 // Funciones de desalojo (versiones directas para evitar deadlocks)
-worker_t* buscar_worker_con_menor_prioridad_directo(master_t* master, int new_priority);
+worker_t* buscar_worker_con_menor_prioridad_directo(master_t* master, query_t* new_query);
 void desalojar_query_de_worker_directo(master_t* master, worker_t* worker, query_t* new_query);
 void completar_desalojo_worker(master_t* master, worker_t* worker, uint32_t pc);
 
 // Funciones de cancelación
 void completar_cancelacion_query(master_t* master, worker_t* worker, uint32_t pc);
 
+// Funciones de la rueda de timers
+uint64_t tiempo_actual_ms(void);
+timer_wheel_t* timer_wheel_crear(void);
+bool timer_wheel_iniciar(timer_wheel_t* wheel);
+void timer_wheel_detener(timer_wheel_t* wheel);
+void timer_wheel_destruir(timer_wheel_t* wheel);
+void timer_programar(timer_wheel_t* wheel, int delay_ms, int periodo_ms, timer_callback_t callback, void* arg, bool liberar_arg);
+
+// Funciones de supervisión de Workers
+void programar_heartbeats(master_t* master);
+void declarar_worker_caido(master_t* master, worker_t* worker, const char* motivo);  // ⚠️ Llamar con mutex tomado
+void marcar_worker_inalcanzable(master_t* master, int socket, int error);
+
 // Funciones de red
 void* manejar_conexion(void* arg);
-int configurar_socket_servidor(int port);
+void desregistrar_conexion(master_t* master, int client_socket);
+int configurar_socket_servidor(int port, int tcp_user_timeout);
 void manejar_mensaje_query_control(master_t* master, int client_socket, op_code codigo, void* payload, int size);
 void manejar_mensaje_worker(master_t* master, int client_socket, op_code codigo, void* payload, int size);
 worker_t* buscar_worker_por_socket(master_t* master, int socket);
@@ -207,6 +330,12 @@ void log_priority_change(t_log* logger, uint64_t query_id, int old_priority, int
 void log_read_sent_to_qc(t_log* logger, uint64_t query_id, char* worker_id);
 void log_desalojo_por_desconexion(t_log* logger, uint64_t query_id, int priority, char* worker_id);
 
+// Métricas
+void log_metricas(master_t* master);
+void programar_metricas(master_t* master);
+
+const char* algorithm_to_string(scheduling_algorithm_t algorithm);
+
 // Utilidad para convertir string a t_log_level
 t_log_level log_level_from_string(char* level);
 
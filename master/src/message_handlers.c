@@ -21,13 +21,28 @@ void manejar_mensaje_query_control(master_t* master, int client_socket, op_code
             // Deserializar el payload
             char* path = NULL;
             int priority = 0;
-            deserializar_new_query(payload, &path, &priority);
+            int deadline_ms = 0;
+            int costo_ms = 0;
+            deserializar_new_query_con_deadline(payload, size, &path, &priority, &deadline_ms, &costo_ms);
             
             if (!path) {
                 log_error(master->logger, "[MASTER] Error deserializando NEW_QUERY");
                 return;
             }
             
+            // En modo PRIORIDADES, validar que la prioridad sea mayor o igual a 0 (según enunciado)
+            if (master->config->algoritmo_planificacion != ALGORITHM_FIFO && priority < 0) {
+                log_error(master->logger, "[MASTER] Prioridad inválida (%d). Debe ser >= 0", priority);
+                free(path);
+                return;
+            }
+            
+            // Control de admisión antes de asignar ID: una query rechazada no consume IDs
+            if (!admitir_query(master, client_socket, priority)) {
+                free(path);
+                return;
+            }
+            
             // Generar ID para la nueva query
             uint64_t query_id = generar_id_query(master);
             
@@ -36,23 +51,28 @@ void manejar_mensaje_query_control(master_t* master, int client_socket, op_code
             if (master->config->algoritmo_planificacion == ALGORITHM_FIFO) {
                 priority = (int)query_id;
                 log_debug(master->logger, "[MASTER] Modo FIFO: prioridad asignada automáticamente = %d (orden de llegada)", priority);
-            } else {
-                // En modo PRIORIDADES, validar que la prioridad sea mayor o igual a 0 (según enunciado)
-                if (priority < 0) {
-                    log_error(master->logger, "[MASTER] Prioridad inválida (%d). Debe ser >= 0", priority);
-                    free(path);
-                    return;
-                }
             }
             
             // Crear la query
-            query_t* query = query_crear(query_id, path, priority, client_socket);
+            query_t* query = query_crear(master, query_id, path, priority, client_socket);
             if (!query) {
                 log_error(master->logger, "[MASTER] Error creando query");
                 free(path);
                 return;
             }
             
+            // Fijar la versión actual del script: la query se despacha y se reanuda siempre
+            // con este contenido aunque el archivo cambie después (lectura fuera del mutex)
+            query->script = cache_scripts_cargar(master, path);
+            
+            // El deadline llega relativo: se fija contra el reloj del Master al admitir la query
+            if (deadline_ms > 0) {
+                query->deadline = tiempo_actual_ms() + deadline_ms;
+                query->costo_estimado = costo_ms > 0 ? costo_ms : 0;
+                log_debug(master->logger, "[MASTER] Query %lu con deadline en %d ms (costo estimado %d ms)",
+                          query_id, deadline_ms, query->costo_estimado);
+            }
+            
             // Crear QueryControl
             query_control_t* qc = query_control_crear(client_socket);
             qc->connected_query_id = query_id;
@@ -76,7 +96,7 @@ void manejar_mensaje_query_control(master_t* master, int client_socket, op_code
                 list_remove_element(master->query_controls, qc);
                 pthread_mutex_unlock(&master->main_mutex);
                 query_control_destruir(qc);
-                query_destruir(query);
+                query_destruir(master, query);
                 free(ack_payload);
                 free(path);
                 return;
@@ -104,10 +124,14 @@ void manejar_mensaje_worker(master_t* master, int client_socket, op_code codigo,
     switch (codigo) {
         case HANDSHAKE_WORKER: {
             char worker_id[MAX_WORKER_ID_SIZE];
+            char** hashes = NULL;
+            int cantidad_hashes = 0;
+            int capacidades = 0;
 
            if (payload != NULL && size >= sizeof(int)) {
                 int id_recibido = 0;
-                memcpy(&id_recibido, payload, sizeof(int));
+                // Un payload más largo que el ID trae las capacidades y los scripts que el Worker ya tiene
+                deserializar_handshake_worker(payload, size, &id_recibido, &capacidades, &hashes, &cantidad_hashes);
                 // Formatear el nombre como pide el enunciado o logs
                 snprintf(worker_id, MAX_WORKER_ID_SIZE, "WORKER_%d", id_recibido);
             } else {
@@ -119,9 +143,22 @@ void manejar_mensaje_worker(master_t* master, int client_socket, op_code codigo,
             worker_t* worker = worker_crear(worker_id, client_socket);
             if (!worker) {
                 log_error(master->logger, "[MASTER] Error creando worker %s", worker_id);
+                for (int i = 0; i < cantidad_hashes; i++) free(hashes[i]);
+                free(hashes);
                 return;
             }
             
+            worker->capacidades = capacidades;
+            for (int i = 0; i < cantidad_hashes; i++) {
+                dictionary_put(worker->scripts, hashes[i], NULL);
+                free(hashes[i]);
+            }
+            free(hashes);
+            if (capacidades != 0) {
+                log_debug(master->logger, "[MASTER] Worker %s anunció capacidades 0x%x (%d scripts en caché)",
+                          worker_id, capacidades, cantidad_hashes);
+            }
+            
             pthread_mutex_lock(&master->main_mutex);
             
             // Verificar que no exista ya un worker con ese socket
@@ -250,6 +287,17 @@ void manejar_mensaje_worker(master_t* master, int client_socket, op_code codigo,
                 // Log de finalización
                 log_query_finished(master->logger, query->id, worker->id);
                 
+                if (query->deadline > 0) {
+                    uint64_t fin = tiempo_actual_ms();
+                    if (fin > query->deadline) {
+                        master->metricas.deadlines_incumplidos++;
+                        log_info(master->logger, "[METRICAS] Query %lu terminó %lu ms después de su deadline",
+                                 query->id, fin - query->deadline);
+                    } else {
+                        master->metricas.deadlines_cumplidos++;
+                    }
+                }
+                
                 // Notificar al Query Control usando utils
                 int finish_size = 0;
                 void* finish_payload = serializar_ack_con_id(query->id, &finish_size);
@@ -259,12 +307,16 @@ void manejar_mensaje_worker(master_t* master, int client_socket, op_code codigo,
                 }
                 free(finish_payload);
                 
-                // Cleanup
+                // Cleanup. Si terminó antes de recibir el CANCEL_QUERY, sacarla también de
+                // pending_cancellations: si no, el ack de cancelación la destruiría de nuevo
                 dictionary_remove(master->exec_map, worker->id);
+                if (dictionary_get(master->pending_cancellations, worker->id) == query) {
+                    dictionary_remove(master->pending_cancellations, worker->id);
+                }
                 worker->status = WORKER_IDLE;
                 worker->current_query_id = 0;
                 
-                query_destruir(query);
+                query_destruir(master, query);
             }
             
             // Si habia una preemption pendiente, asignar DIRECTAMENTE al worker
@@ -278,8 +330,6 @@ void manejar_mensaje_worker(master_t* master, int client_socket, op_code codigo,
                 
                 // Asignar directamente al worker
                 pending_query->state = QUERY_EXEC;
-                strncpy(pending_query->worker_id, worker->id, MAX_WORKER_ID_SIZE - 1);
-                pending_query->worker_id[MAX_WORKER_ID_SIZE - 1] = '\0';
                 
                 worker->status = WORKER_BUSY;
                 worker->current_query_id = pending_query->id;
@@ -290,18 +340,18 @@ void manejar_mensaje_worker(master_t* master, int client_socket, op_code codigo,
                 int worker_socket = worker->socket;
                 uint64_t q_id = pending_query->id;
                 int q_priority = pending_query->priority;
-                char* q_path = strdup(pending_query->path_query);
-                uint32_t q_pc = pending_query->pc;
+                char hash_inline[HASH_SCRIPT_SIZE];
+                int execute_size = 0;
+                void* execute_payload = armar_execute_query(master, worker, pending_query, hash_inline, &execute_size);
                 
                 pthread_mutex_unlock(&master->main_mutex);
                 
                 // Enviar EXECUTE_QUERY al worker
-                int execute_size = 0;
-                void* execute_payload = serializar_execute_query(q_id, q_path, q_pc, &execute_size);
                 
                 if (execute_payload && enviar_paquete(worker_socket, EXECUTE_QUERY, execute_payload, execute_size) == 0) {
                     log_info(master->logger, "## Query %lu (prioridad %d) ejecutandose en Worker %s (tras preemption fallida)", 
                              q_id, q_priority, worker->id);
+                    registrar_script_enviado(master, worker->id, hash_inline);
                 } else {
                     log_error(master->logger, "[MASTER] Error enviando EXECUTE_QUERY tras preemption fallida");
                     // Revertir y mover a ready_queue
@@ -315,7 +365,6 @@ void manejar_mensaje_worker(master_t* master, int client_socket, op_code codigo,
                 }
                 
                 if (execute_payload) free(execute_payload);
-                free(q_path);
             } else {
                 pthread_mutex_unlock(&master->main_mutex);
                 
@@ -326,6 +375,81 @@ void manejar_mensaje_worker(master_t* master, int client_socket, op_code codigo,
             break;
         }
         
+        case HEARTBEAT_ACK: {
+            worker_t* worker = buscar_worker_por_socket(master, client_socket);
+            if (!worker) return;
+            
+            uint64_t seq = 0;
+            uint64_t query_id = 0;
+            uint32_t pc = 0;
+            bool con_contexto = false;
+            if (payload) {
+                deserializar_heartbeat_ack(payload, size, &seq, &query_id, &pc, &con_contexto);
+            }
+            
+            pthread_mutex_lock(&master->main_mutex);
+            worker->heartbeats_pendientes = 0;
+            
+            // El PC solo vale si es de la query que el Master tiene en ejecución en ese worker
+            query_t* query = (query_t*)dictionary_get(master->exec_map, worker->id);
+            if (con_contexto && query && query->id == query_id && query->state == QUERY_EXEC) {
+                query->pc = pc;
+                worker->pc_query_id = query_id;
+                worker->pc_recibido_ms = tiempo_actual_ms();
+            }
+            pthread_mutex_unlock(&master->main_mutex);
+            break;
+        }
+        
+        case SCRIPT_FALTANTE: {
+            worker_t* worker = buscar_worker_por_socket(master, client_socket);
+            if (!worker) return;
+            if (!payload || size < (int)(sizeof(uint64_t) + HASH_SCRIPT_SIZE)) {
+                log_warning(master->logger, "[MASTER] SCRIPT_FALTANTE mal formado del Worker %s", worker->id);
+                return;
+            }
+            
+            uint64_t query_id = 0;
+            char* hash = NULL;
+            deserializar_script_faltante(payload, &query_id, &hash);
+            
+            pthread_mutex_lock(&master->main_mutex);
+            // El worker no tiene el script (se reinició o perdió su caché): sacarlo de su
+            // conjunto para que armar_execute_query vuelva a mandar el contenido inline
+            dictionary_remove(worker->scripts, hash);
+            
+            query_t* query = (query_t*)dictionary_get(master->exec_map, worker->id);
+            if (!query || query->id != query_id) {
+                // La query ya terminó, se canceló o se desalojó: no hay nada que reenviar
+                pthread_mutex_unlock(&master->main_mutex);
+                free(hash);
+                break;
+            }
+            
+            int worker_socket = worker->socket;
+            char worker_id[MAX_WORKER_ID_SIZE];
+            strncpy(worker_id, worker->id, MAX_WORKER_ID_SIZE - 1);
+            worker_id[MAX_WORKER_ID_SIZE - 1] = '\0';
+            char hash_inline[HASH_SCRIPT_SIZE];
+            int execute_size = 0;
+            void* execute_payload = armar_execute_query(master, worker, query, hash_inline, &execute_size);
+            pthread_mutex_unlock(&master->main_mutex);
+            
+            log_info(master->logger, "[SCRIPTS] Worker %s no tiene el script %s, reenviando query %lu con el contenido",
+                     worker_id, hash, query_id);
+            
+            // Si el envío falla el worker se está cayendo y la query se replanifica al desconectarse
+            if (execute_payload && enviar_paquete(worker_socket, EXECUTE_QUERY, execute_payload, execute_size) == 0) {
+                registrar_script_enviado(master, worker_id, hash_inline);
+            } else {
+                log_error(master->logger, "[MASTER] Error reenviando EXECUTE_QUERY al Worker %s (query %lu)", worker_id, query_id);
+            }
+            
+            if (execute_payload) free(execute_payload);
+            free(hash);
+            break;
+        }
+        
         case READ_RESULT: {
             // Buscar el worker
             worker_t* worker = buscar_worker_por_socket(master, client_socket);
@@ -6,7 +6,7 @@ void planificador_inicializar(master_t* master) {
     if (!master) return;
     
     log_info(master->logger, "[SCHEDULER] Planificador inicializado con algoritmo %s", 
-             master->config->algoritmo_planificacion == ALGORITHM_FIFO ? "FIFO" : "PRIORIDADES");
+             algorithm_to_string(master->config->algoritmo_planificacion));
 }
 
 void planificar_query(master_t* master, query_t* query) {
@@ -23,8 +23,6 @@ void planificar_query(master_t* master, query_t* query) {
     if (idle_worker) {
         // Asignar directamente al worker idle
         query->state = QUERY_EXEC;
-        strncpy(query->worker_id, idle_worker->id, MAX_WORKER_ID_SIZE - 1);
-        query->worker_id[MAX_WORKER_ID_SIZE - 1] = '\0';
         
         idle_worker->status = WORKER_BUSY;
         idle_worker->current_query_id = query->id;
@@ -41,21 +39,22 @@ void planificar_query(master_t* master, query_t* query) {
         int workers_disponibles_ahora = contar_workers_disponibles(master);
         int total_workers = contar_workers_totales(master);
         
+        // Armar EXECUTE_QUERY con el mutex tomado (consulta la caché de scripts del worker)
+        char hash_inline[HASH_SCRIPT_SIZE];
+        int execute_size = 0;
+        void* execute_payload = armar_execute_query(master, idle_worker, query, hash_inline, &execute_size);
+        
         // Liberar mutex ANTES de operación de red para evitar bloqueos
         pthread_mutex_unlock(&master->main_mutex);
         
         log_debug(master->logger, "[SCHEDULER] Query %lu asignada DIRECTAMENTE a Worker %s (IDLE). Disponibles: %d/%d", 
                   query->id, worker_id, workers_disponibles_ahora, total_workers);
         
-        // Enviar mensaje al worker usando utils
-        int execute_size = 0;
-        void* execute_payload = serializar_execute_query(query->id, query->path_query, query->pc, &execute_size);
-        
         if (!execute_payload) {
             log_error(master->logger, "Error: No se pudo serializar EXECUTE_QUERY para query %lu", query->id);
             // Revertir cambios y devolver query a ready_queue
             pthread_mutex_lock(&master->main_mutex);
-            worker_t* worker_check = buscar_worker_por_id(master, worker_id);
+            worker_t* worker_check = buscar_worker_por_id_directo(master, worker_id);
             if (worker_check) {
                 worker_check->status = WORKER_IDLE;
                 worker_check->current_query_id = 0;
@@ -69,10 +68,11 @@ void planificar_query(master_t* master, query_t* query) {
         
         if (enviar_paquete(worker_socket, EXECUTE_QUERY, execute_payload, execute_size) == 0) {
             log_query_sent_to_worker(master->logger, query->id, query->priority, worker_id);
+            registrar_script_enviado(master, worker_id, hash_inline);
         } else {
             log_error(master->logger, "[SCHEDULER] Error enviando EXECUTE_QUERY al worker %s", worker_id);
             pthread_mutex_lock(&master->main_mutex);
-            worker_t* worker_check = buscar_worker_por_id(master, worker_id);
+            worker_t* worker_check = buscar_worker_por_id_directo(master, worker_id);
             if (worker_check) {
                 worker_check->status = WORKER_IDLE;
                 worker_check->current_query_id = 0;
@@ -87,9 +87,9 @@ void planificar_query(master_t* master, query_t* query) {
         return;
     }
     
-    // SEGUNDO: Si no hay workers libres, intentar desalojar (solo en algoritmo PRIORIDADES)
-    if (master->config->algoritmo_planificacion == ALGORITHM_PRIORIDADES) {
-        worker_t* worker_to_preempt = buscar_worker_con_menor_prioridad_directo(master, query->priority);
+    // SEGUNDO: Si no hay workers libres, intentar desalojar (PRIORIDADES y EDF)
+    if (master->config->algoritmo_planificacion != ALGORITHM_FIFO) {
+        worker_t* worker_to_preempt = buscar_worker_con_menor_prioridad_directo(master, query);
         if (worker_to_preempt) {
             log_debug(master->logger, "[SCHEDULER] No hay workers libres. Query %lu (prioridad %d) desalojara a query en worker %s", 
                      query->id, query->priority, worker_to_preempt->id);
@@ -127,7 +127,7 @@ void planificar_siguiente_query(master_t* master) {
     worker_t* idle_worker = NULL;
     for (int i = 0; i < list_size(master->workers); i++) {
         worker_t* worker = (worker_t*)list_get(master->workers, i);
-        if (worker && worker->status == WORKER_IDLE) {
+        if (worker && !worker->caido && worker->status == WORKER_IDLE) {
             idle_worker = worker;
             break;
         }
@@ -149,15 +149,16 @@ void planificar_siguiente_query(master_t* master) {
         // FIFO: tomar el primero
         next_query = (query_t*)queue_pop(master->ready_queue);
     } else {
-        // PRIORIDADES: buscar el de mayor prioridad (número menor)
+        // PRIORIDADES: buscar el de mayor prioridad (número menor); EDF: el deadline más cercano
         next_query = obtener_query_mayor_prioridad(master);
     }
     
     if (next_query) {
+        // Se liberó un lugar en READY para los Query Control demorados por admisión
+        pthread_cond_broadcast(&master->cupo_ready);
+        
         // Actualizar estados (ya tenemos el mutex)
         next_query->state = QUERY_EXEC;
-        strncpy(next_query->worker_id, idle_worker->id, MAX_WORKER_ID_SIZE - 1);
-        next_query->worker_id[MAX_WORKER_ID_SIZE - 1] = '\0';
         
         idle_worker->status = WORKER_BUSY;
         idle_worker->current_query_id = next_query->id;
@@ -175,23 +176,24 @@ void planificar_siguiente_query(master_t* master) {
         int workers_disponibles_ahora = contar_workers_disponibles(master);
         int total_workers = contar_workers_totales(master);
         
+        // Armar EXECUTE_QUERY con el mutex tomado (consulta la caché de scripts del worker)
+        char hash_inline[HASH_SCRIPT_SIZE];
+        int execute_size = 0;
+        void* execute_payload = armar_execute_query(master, idle_worker, next_query, hash_inline, &execute_size);
+        
         pthread_mutex_unlock(&master->main_mutex);
         
         // Log DETALLADO de asignación
         log_debug(master->logger, "[SCHEDULER] Asignando Query %lu (prioridad %d) a Worker %s. Workers disponibles: %d/%d", 
                   next_query->id, next_query->priority, worker_id, workers_disponibles_ahora, total_workers);
         
-        // Enviar mensaje EXECUTE_QUERY al worker usando utils
-        int execute_size = 0;
-        void* execute_payload = serializar_execute_query(next_query->id, next_query->path_query, next_query->pc, &execute_size);
-        
         // FIX Bug 1: Verificar si serialización falló (mutex YA fue liberado, no intentar liberarlo de nuevo)
         if (!execute_payload) {
             log_error(master->logger, "Error: No se pudo serializar EXECUTE_QUERY para query %lu", next_query->id);
             // Revertir cambios y devolver query a ready_queue
             pthread_mutex_lock(&master->main_mutex);
             // Re-buscar worker por si fue modificado/eliminado
-            worker_t* worker_check = buscar_worker_por_id(master, worker_id);
+            worker_t* worker_check = buscar_worker_por_id_directo(master, worker_id);
             if (worker_check) {
                 worker_check->status = WORKER_IDLE;
                 worker_check->current_query_id = 0;
@@ -205,12 +207,13 @@ void planificar_siguiente_query(master_t* master) {
         
         if (enviar_paquete(worker_socket, EXECUTE_QUERY, execute_payload, execute_size) == 0) {
             log_query_sent_to_worker(master->logger, next_query->id, next_query->priority, worker_id);
+            registrar_script_enviado(master, worker_id, hash_inline);
         } else {
             log_error(master->logger, "[SCHEDULER] Error enviando EXECUTE_QUERY al worker %s", worker_id);
             // Revertir cambios y devolver query a ready_queue
             pthread_mutex_lock(&master->main_mutex);
             // Re-buscar worker por si fue modificado/eliminado
-            worker_t* worker_check = buscar_worker_por_id(master, worker_id);
+            worker_t* worker_check = buscar_worker_por_id_directo(master, worker_id);
             if (worker_check) {
                 worker_check->status = WORKER_IDLE;
                 worker_check->current_query_id = 0;
@@ -245,8 +248,6 @@ void asignar_query_a_worker(master_t* master, query_t* query, worker_t* worker)
     
     // Actualizar estados (con mutex tomado para consistencia)
     query->state = QUERY_EXEC;
-    strncpy(query->worker_id, worker->id, MAX_WORKER_ID_SIZE - 1);
-    query->worker_id[MAX_WORKER_ID_SIZE - 1] = '\0';
     
     worker->status = WORKER_BUSY;
     worker->current_query_id = query->id;
@@ -260,20 +261,21 @@ void asignar_query_a_worker(master_t* master, query_t* query, worker_t* worker)
     strncpy(worker_id, worker->id, MAX_WORKER_ID_SIZE - 1);
     worker_id[MAX_WORKER_ID_SIZE - 1] = '\0';
     
+    // Armar EXECUTE_QUERY con el mutex tomado (consulta la caché de scripts del worker)
+    char hash_inline[HASH_SCRIPT_SIZE];
+    int execute_size = 0;
+    void* execute_payload = armar_execute_query(master, worker, query, hash_inline, &execute_size);
+    
     // Liberar mutex ANTES de operación de red
     pthread_mutex_unlock(&master->main_mutex);
     
-    // Enviar mensaje EXECUTE_QUERY al worker usando utils
-    int execute_size = 0;
-    void* execute_payload = serializar_execute_query(query->id, query->path_query, query->pc, &execute_size);
-    
     // FIX Bug 1: Verificar si serialización falló (mutex YA fue liberado, no intentar liberarlo de nuevo)
     if (!execute_payload) {
         log_error(master->logger, "Error: No se pudo serializar EXECUTE_QUERY para query %lu", query->id);
         // Revertir cambios y devolver query a ready_queue
         pthread_mutex_lock(&master->main_mutex);
         // Re-buscar worker por si fue modificado/eliminado
-        worker_t* worker_check = buscar_worker_por_id(master, worker_id);
+        worker_t* worker_check = buscar_worker_por_id_directo(master, worker_id);
         if (worker_check) {
             worker_check->status = WORKER_IDLE;
             worker_check->current_query_id = 0;
@@ -287,12 +289,13 @@ void asignar_query_a_worker(master_t* master, query_t* query, worker_t* worker)
     
     if (enviar_paquete(worker_socket, EXECUTE_QUERY, execute_payload, execute_size) == 0) {
         log_query_sent_to_worker(master->logger, query->id, query->priority, worker_id);
+        registrar_script_enviado(master, worker_id, hash_inline);
     } else {
         log_error(master->logger, "[SCHEDULER] Error enviando EXECUTE_QUERY al worker %s", worker_id);
         // Revertir cambios y devolver query a ready_queue
         pthread_mutex_lock(&master->main_mutex);
         // Re-buscar worker por si fue modificado/eliminado
-        worker_t* worker_check = buscar_worker_por_id(master, worker_id);
+        worker_t* worker_check = buscar_worker_por_id_directo(master, worker_id);
         if (worker_check) {
             worker_check->status = WORKER_IDLE;
             worker_check->current_query_id = 0;
@@ -306,6 +309,29 @@ void asignar_query_a_worker(master_t* master, query_t* query, worker_t* worker)
     free(execute_payload);
 }
 
+/**
+ * @brief Indica si la query a debe ejecutarse antes que b según el algoritmo configurado
+ *
+ * PRIORIDADES compara el número de prioridad (menor = más importante).
+ * EDF compara deadlines absolutos; las queries sin deadline van después de todas las
+ * que tienen uno, y entre ellas se usa la prioridad. A igual deadline gana la de menor
+ * costo estimado.
+ */
+bool query_precede(master_t* master, query_t* a, query_t* b) {
+    if (!a || !b) return false;
+
+    if (master->config->algoritmo_planificacion == ALGORITHM_EDF) {
+        if (a->deadline != 0 && b->deadline == 0) return true;
+        if (a->deadline == 0 && b->deadline != 0) return false;
+        if (a->deadline != b->deadline) return a->deadline < b->deadline;
+        if (a->deadline != 0 && a->costo_estimado != b->costo_estimado) {
+            return a->costo_estimado < b->costo_estimado;
+        }
+    }
+
+    return a->priority < b->priority;
+}
+
 query_t* obtener_query_mayor_prioridad(master_t* master) {
     if (!master || queue_is_empty(master->ready_queue)) return NULL;
     
@@ -339,7 +365,7 @@ query_t* obtener_query_mayor_prioridad(master_t* master) {
     for (int i = 1; i < list_size(temp_list); i++) {
         query_t* current = (query_t*)list_get(temp_list, i);
         // FIX Bug 2: Validar que current no sea NULL
-        if (current && current->priority < highest_priority->priority) {
+        if (current && query_precede(master, current, highest_priority)) {
             highest_priority = current;
             best_index = i;
         }
@@ -374,38 +400,132 @@ query_t* obtener_query_mayor_prioridad(master_t* master) {
     return highest_priority;
 }
 
+// ========== CONTROL DE ADMISIÓN ==========
+
+/**
+ * @brief Indica si una query de la prioridad dada entra en READY según los topes configurados
+ *
+ * ⚠️ PRECONDICIÓN: llamar con master->main_mutex tomado.
+ *
+ * Las bandas agrupan ANCHO_BANDA_PRIORIDAD niveles y se calculan sobre la prioridad
+ * original, para que el aging no mueva queries de una banda a otra. En FIFO la
+ * prioridad no existe, así que solo aplica el tope total.
+ */
+bool hay_cupo_en_ready(master_t* master, int priority) {
+    if (!master) return false;
+
+    int en_ready = queue_size(master->ready_queue);
+    if (master->config->max_queries_ready > 0 && en_ready >= master->config->max_queries_ready) {
+        return false;
+    }
+
+    if (master->config->max_queries_por_banda > 0 &&
+        master->config->algoritmo_planificacion != ALGORITHM_FIFO) {
+        int ancho = master->config->ancho_banda_prioridad;
+        int banda = priority / ancho;
+        int en_banda = 0;
+
+        t_list* elementos = master->ready_queue->elements;
+        for (int i = 0; i < list_size(elementos); i++) {
+            query_t* query = (query_t*)list_get(elementos, i);
+            if (query && query->priority_original / ancho == banda) {
+                en_banda++;
+            }
+        }
+
+        if (en_banda >= master->config->max_queries_por_banda) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Decide si se acepta una NEW_QUERY (no toma el mutex al entrar)
+ *
+ * Con ADMISION_RECHAZAR responde QUERY_RECHAZADA (ERROR_MASTER_WORKER_NO_DISPONIBLE
+ * + retry-after) y devuelve false. Con ADMISION_BACKPRESSURE bloquea el hilo de la
+ * conexión hasta que haya cupo: mientras tanto no se lee más de ese Query Control y
+ * TCP frena al cliente.
+ *
+ * El cupo no se reserva: dos admisiones simultáneas pueden pasarse del tope por una query.
+ */
+bool admitir_query(master_t* master, int qc_socket, int priority) {
+    if (!master) return false;
+
+    pthread_mutex_lock(&master->main_mutex);
+
+    bool demorada = false;
+    while (master->running && !hay_cupo_en_ready(master, priority)) {
+        if (master->config->politica_admision == ADMISION_RECHAZAR) {
+            master->metricas.queries_rechazadas++;
+            int en_ready = queue_size(master->ready_queue);
+            pthread_mutex_unlock(&master->main_mutex);
+
+            log_info(master->logger, "[ADMISION] Query con prioridad %d rechazada (%d en READY). Reintentar en %d ms",
+                     priority, en_ready, master->config->retry_after_admision);
+
+            int rechazo_size = 0;
+            void* rechazo_payload = serializar_query_rechazada(ERROR_MASTER_WORKER_NO_DISPONIBLE,
+                                                               master->config->retry_after_admision,
+                                                               "READY sin cupo", &rechazo_size);
+            if (enviar_paquete(qc_socket, QUERY_RECHAZADA, rechazo_payload, rechazo_size) != 0) {
+                log_warning(master->logger, "[ADMISION] Error enviando QUERY_RECHAZADA (socket %d)", qc_socket);
+            }
+            free(rechazo_payload);
+            return false;
+        }
+
+        if (!demorada) {
+            demorada = true;
+            master->metricas.queries_demoradas++;
+            log_info(master->logger, "[ADMISION] READY sin cupo, se deja de leer del Query Control (socket %d)", qc_socket);
+        }
+        pthread_cond_wait(&master->cupo_ready, &master->main_mutex);
+    }
+
+    if (!master->running) {
+        pthread_mutex_unlock(&master->main_mutex);
+        return false;
+    }
+
+    master->metricas.queries_admitidas++;
+    pthread_mutex_unlock(&master->main_mutex);
+    return true;
+}
+
 // ========== HILOS DEL PLANIFICADOR ==========
 // Nota: El hilo de planificador fue eliminado - la planificación se hace directamente
-// cuando llegan requests para simplificar y evitar problemas de concurrencia
+// cuando llegan requests para simplificar y evitar problemas de concurrencia.
+// El aging corre como timer periódico en la rueda de timers (ver timers.c).
 
-void* funcion_hilo_aging(void* arg) {
+static void timer_aging(void* arg) {
     master_t* master = (master_t*)arg;
-    
-    // Desactivar aging en modo FIFO (no tiene sentido aplicar aging cuando no se usa prioridad)
-    if (master->config->algoritmo_planificacion == ALGORITHM_FIFO) {
-        log_info(master->logger, "[AGING] Aging deshabilitado (algoritmo FIFO no usa prioridades)");
-        return NULL;
+    if (!master->running) return;
+
+    // Aplicar aging a queries en ready_queue
+    aplicar_aging(master);
+}
+
+void programar_aging(master_t* master) {
+    if (!master) return;
+
+    // Desactivar aging en FIFO y EDF (no tiene sentido aplicar aging cuando no se ordena por prioridad)
+    if (master->config->algoritmo_planificacion != ALGORITHM_PRIORIDADES) {
+        log_info(master->logger, "[AGING] Aging deshabilitado (algoritmo %s no usa prioridades)",
+                 algorithm_to_string(master->config->algoritmo_planificacion));
+        return;
     }
-    
+
     if (master->config->tiempo_aging <= 0) {
         log_info(master->logger, "[AGING] Aging deshabilitado");
-        return NULL;
-    }
-    
-    log_info(master->logger, "[AGING] Hilo de aging iniciado (cada %d ms)", master->config->tiempo_aging);
-    
-    while (master->running) {
-        // Esperar el tiempo configurado
-        sleep_ms(master->config->tiempo_aging);
-        
-        if (!master->running) break;
-        
-        // Aplicar aging a queries en ready_queue
-        aplicar_aging(master);
+        return;
     }
-    
-    log_info(master->logger, "[AGING] Hilo de aging terminado");
-    return NULL;
+
+    timer_programar(master->timers, master->config->tiempo_aging, master->config->tiempo_aging,
+                    timer_aging, master, false);
+    log_info(master->logger, "[AGING] Aging programado (cada %d ms)", master->config->tiempo_aging);
 }
 
 void aplicar_aging(master_t* master) {
@@ -450,24 +570,54 @@ void aplicar_aging(master_t* master) {
 
 // ========== FUNCIONES DE DESALOJO ==========
 
-worker_t* buscar_worker_con_menor_prioridad_directo(master_t* master, int new_priority) {
-    if (!master) return NULL;
+// Datos del timeout de un desalojo pendiente (los libera la rueda de timers)
+typedef struct {
+    master_t* master;
+    char worker_id[MAX_WORKER_ID_SIZE];
+    uint64_t query_id;  // Query a la que se le pidió el desalojo
+} timeout_desalojo_t;
+
+static void timer_timeout_desalojo(void* arg) {
+    timeout_desalojo_t* timeout = (timeout_desalojo_t*)arg;
+    master_t* master = timeout->master;
+    if (!master->running) return;
+
+    pthread_mutex_lock(&master->main_mutex);
+
+    // Si el worker ya contestó (o se desconectó) el timer no tiene efecto
+    for (int i = 0; i < list_size(master->workers); i++) {
+        worker_t* worker = (worker_t*)list_get(master->workers, i);
+        if (worker && strcmp(worker->id, timeout->worker_id) == 0) {
+            if (worker->status == WORKER_PREEMPTING && worker->current_query_id == timeout->query_id) {
+                log_warning(master->logger, "[SCHEDULER] Worker %s no respondió el desalojo de la Query %lu en %d ms",
+                            worker->id, timeout->query_id, master->config->timeout_desalojo);
+                declarar_worker_caido(master, worker, "timeout de desalojo");
+            }
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&master->main_mutex);
+}
+
+worker_t* buscar_worker_con_menor_prioridad_directo(master_t* master, query_t* new_query) {
+    if (!master || !new_query) return NULL;
     
     worker_t* lowest_priority_worker = NULL;
-    int lowest_priority = -1; // -1 indica que aún no se ha encontrado ningún candidato
+    query_t* lowest_priority_query = NULL; // NULL indica que aún no se ha encontrado ningún candidato
     
     for (int i = 0; i < list_size(master->workers); i++) {
         worker_t* worker = (worker_t*)list_get(master->workers, i);
         // Considerar workers BUSY y PREEMPTING (pueden tener queries en ejecucion)
-        if (worker && (worker->status == WORKER_BUSY || worker->status == WORKER_PREEMPTING)) {
+        if (worker && !worker->caido && (worker->status == WORKER_BUSY || worker->status == WORKER_PREEMPTING)) {
             // Buscar la query que está ejecutando este worker
             query_t* running_query = (query_t*)dictionary_get(master->exec_map, worker->id);
             
-            if (running_query && running_query->priority > new_priority) {
-                // Esta query tiene menor prioridad (número mayor) que la nueva
-                // Queremos desalojar la query con el MAYOR número de prioridad (la menos importante)
-                if (lowest_priority == -1 || running_query->priority > lowest_priority) {
-                    lowest_priority = running_query->priority;
+            if (running_query && query_precede(master, new_query, running_query)) {
+                // La nueva query va antes que esta (mayor prioridad o deadline más cercano)
+                // Queremos desalojar la menos urgente de todas las candidatas
+                if (!lowest_priority_query || query_precede(master, lowest_priority_query, running_query)) {
+                    lowest_priority_query = running_query;
                     lowest_priority_worker = worker;
                 }
             }
@@ -485,7 +635,7 @@ void desalojar_query_de_worker_directo(master_t* master, worker_t* worker, query
     if (worker->status == WORKER_PREEMPTING) {
         query_t* waiting_query = (query_t*)dictionary_get(master->pending_preemptions, worker->id);
         if (waiting_query) {
-            if (new_query->priority < waiting_query->priority) {
+            if (query_precede(master, new_query, waiting_query)) {
                 // La nueva query tiene mayor prioridad, reemplazarla
                 log_info(master->logger, "[SCHEDULER] Query %lu (P%d) reemplaza a Query %lu (P%d) en pending_preemptions de Worker %s",
                          new_query->id, new_query->priority, waiting_query->id, waiting_query->priority, worker->id);
@@ -513,8 +663,6 @@ void desalojar_query_de_worker_directo(master_t* master, worker_t* worker, query
         // Si no hay query en ejecución, asignar directamente
         // Actualizar estados directamente (ya tenemos el mutex)
         new_query->state = QUERY_EXEC;
-        strncpy(new_query->worker_id, worker->id, MAX_WORKER_ID_SIZE - 1);
-        new_query->worker_id[MAX_WORKER_ID_SIZE - 1] = '\0';
         worker->status = WORKER_BUSY;
         worker->current_query_id = new_query->id;
         dictionary_put(master->exec_map, worker->id, new_query);
@@ -523,8 +671,9 @@ void desalojar_query_de_worker_directo(master_t* master, worker_t* worker, query
         // Guardar datos necesarios para evitar use-after-free si el worker se desconecta
         uint64_t query_id = new_query->id;
         int query_priority = new_query->priority;
+        char hash_inline[HASH_SCRIPT_SIZE];
         int execute_size = 0;
-        void* execute_payload = serializar_execute_query(new_query->id, new_query->path_query, new_query->pc, &execute_size);
+        void* execute_payload = armar_execute_query(master, worker, new_query, hash_inline, &execute_size);
         
         // FIX Bug 1: Verificar si serialización falló (aún tenemos el mutex, revertir cambios)
         if (!execute_payload) {
@@ -560,6 +709,8 @@ void desalojar_query_de_worker_directo(master_t* master, worker_t* worker, query
         
         if (send_result == 0) {
             log_query_sent_to_worker(master->logger, query_id, query_priority, worker->id);
+            // Ya tenemos el mutex y el worker sigue conectado: registrar el script directo
+            if (hash_inline[0] != '\0') dictionary_put(worker->scripts, hash_inline, NULL);
         } else {
             log_error(master->logger, "[SCHEDULER] Error enviando EXECUTE_QUERY al worker %s", worker->id);
             // Revertir cambios y devolver query a ready_queue
@@ -592,6 +743,19 @@ void desalojar_query_de_worker_directo(master_t* master, worker_t* worker, query
     if (enviar_paquete(worker->socket, PREEMPT_QUERY, preempt_payload, preempt_size) == 0) {
         log_debug(master->logger, "[SCHEDULER] Solicitud de desalojo enviada al worker %s para query %lu", 
                  worker->id, preempted_query->id);
+        
+        // Acotar cuánto puede tardar el PREEMPTION_ACK antes de dar al worker por caído
+        if (master->config->timeout_desalojo > 0) {
+            timeout_desalojo_t* timeout = malloc(sizeof(timeout_desalojo_t));
+            if (timeout) {
+                timeout->master = master;
+                strncpy(timeout->worker_id, worker->id, MAX_WORKER_ID_SIZE - 1);
+                timeout->worker_id[MAX_WORKER_ID_SIZE - 1] = '\0';
+                timeout->query_id = preempted_query->id;
+                timer_programar(master->timers, master->config->timeout_desalojo, 0,
+                                timer_timeout_desalojo, timeout, true);
+            }
+        }
     } else {
         log_error(master->logger, "[SCHEDULER] Error enviando desalojo al worker %s", worker->id);
         
@@ -636,7 +800,6 @@ void completar_desalojo_worker(master_t* master, worker_t* worker, uint32_t pc)
     // Actualizar query desalojada con PC real recibido del worker
     preempted_query->state = QUERY_READY;
     preempted_query->pc = pc;
-    memset(preempted_query->worker_id, 0, MAX_WORKER_ID_SIZE);
     
     // Remover query desalojada de exec_map
     dictionary_remove(master->exec_map, worker->id);
@@ -649,8 +812,6 @@ void completar_desalojo_worker(master_t* master, worker_t* worker, uint32_t pc)
     
     // Asignar nueva query al worker
     new_query->state = QUERY_EXEC;
-    strncpy(new_query->worker_id, worker->id, MAX_WORKER_ID_SIZE - 1);
-    new_query->worker_id[MAX_WORKER_ID_SIZE - 1] = '\0';
     
     worker->status = WORKER_BUSY;
     worker->current_query_id = new_query->id;
@@ -665,11 +826,12 @@ void completar_desalojo_worker(master_t* master, worker_t* worker, uint32_t pc)
     worker_id[MAX_WORKER_ID_SIZE - 1] = '\0';
     uint64_t preempted_id = preempted_query->id;
     
-    pthread_mutex_unlock(&master->main_mutex);
-    
-    // Enviar mensaje EXECUTE_QUERY al worker con la nueva query
+    // Armar EXECUTE_QUERY de la nueva query con el mutex tomado (consulta la caché de scripts del worker)
+    char hash_inline[HASH_SCRIPT_SIZE];
     int execute_size = 0;
-    void* execute_payload = serializar_execute_query(new_query->id, new_query->path_query, new_query->pc, &execute_size);
+    void* execute_payload = armar_execute_query(master, worker, new_query, hash_inline, &execute_size);
+    
+    pthread_mutex_unlock(&master->main_mutex);
     
     // FIX Bug 1: Verificar si serialización falló (mutex YA fue liberado, no intentar liberarlo de nuevo)
     if (!execute_payload) {
@@ -677,7 +839,7 @@ void completar_desalojo_worker(master_t* master, worker_t* worker, uint32_t pc)
         // Revertir cambios y devolver query a ready_queue
         pthread_mutex_lock(&master->main_mutex);
         // Re-buscar worker por si fue modificado/eliminado
-        worker_t* worker_check = buscar_worker_por_id(master, worker_id);
+        worker_t* worker_check = buscar_worker_por_id_directo(master, worker_id);
         if (worker_check) {
             worker_check->status = WORKER_IDLE;
             worker_check->current_query_id = 0;
@@ -691,6 +853,7 @@ void completar_desalojo_worker(master_t* master, worker_t* worker, uint32_t pc)
     
     if (enviar_paquete(worker_socket, EXECUTE_QUERY, execute_payload, execute_size) == 0) {
         log_query_sent_to_worker(master->logger, new_query->id, new_query->priority, worker_id);
+        registrar_script_enviado(master, worker_id, hash_inline);
         log_info(master->logger, "[SCHEDULER] Desalojo completado - Query %lu (PC=%u) desalojada, Query %lu asignada al Worker %s", 
                  preempted_id, pc, new_query->id, worker_id);
     } else {
@@ -699,7 +862,7 @@ void completar_desalojo_worker(master_t* master, worker_t* worker, uint32_t pc)
         // Si falla, revertir el estado
         pthread_mutex_lock(&master->main_mutex);
         // Re-buscar worker por si fue modificado/eliminado
-        worker_t* worker_check = buscar_worker_por_id(master, worker_id);
+        worker_t* worker_check = buscar_worker_por_id_directo(master, worker_id);
         if (worker_check) {
             worker_check->status = WORKER_IDLE;
             worker_check->current_query_id = 0;
@@ -751,7 +914,7 @@ void completar_cancelacion_query(master_t* master, worker_t* worker, uint32_t pc
     pthread_mutex_unlock(&master->main_mutex);
     
     // Destruir la query cancelada
-    query_destruir(cancelled_query);
+    query_destruir(master, cancelled_query);
     
     // Intentar asignar nueva query al worker ahora disponible
     planificar_siguiente_query(master);
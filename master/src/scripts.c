@@ -0,0 +1,266 @@
+#include "master.h"
+#include <openssl/evp.h>
+
+// ========== CACHÉ DE SCRIPTS ==========
+// Con PATH_QUERIES configurado el Master lee y hashea (MD5) cada script una sola vez
+// mientras el archivo no cambie (se compara mtime y tamaño en cada NEW_QUERY).
+// Cada query fija al admitirse la versión que había en ese momento y la usa en todos
+// sus despachos, así una query desalojada se reanuda con el mismo contenido en su PC.
+// Los Workers que anuncian la caché en el handshake reciben el contenido inline la
+// primera vez y después solo el hash; así no necesitan un filesystem compartido y
+// reanudar una query desalojada no toca disco. Si un Worker recibe un hash que no
+// tiene (por ejemplo, se reinició) responde SCRIPT_FALTANTE y el Master reenvía el
+// contenido. Los Workers viejos siguen recibiendo solo el path.
+//
+// Un script se libera cuando no lo referencia ninguna query ni es la versión actual
+// de ningún path.
+
+static bool calcular_md5(const void* contenido, int size, char hash[HASH_SCRIPT_SIZE]) {
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int digest_size = 0;
+
+    if (!EVP_Digest(contenido, size, digest, &digest_size, EVP_md5(), NULL)) {
+        return false;
+    }
+
+    for (unsigned int i = 0; i < digest_size && i * 2 < HASH_SCRIPT_SIZE - 1; i++) {
+        sprintf(hash + i * 2, "%02x", digest[i]);
+    }
+    hash[HASH_SCRIPT_SIZE - 1] = '\0';
+    return true;
+}
+
+static void* leer_script(master_t* master, const char* ruta, int* size) {
+    FILE* archivo = fopen(ruta, "rb");
+    if (!archivo) {
+        log_warning(master->logger, "[SCRIPTS] No se pudo abrir %s, se enviará solo el path", ruta);
+        return NULL;
+    }
+
+    fseek(archivo, 0, SEEK_END);
+    long largo = ftell(archivo);
+    fseek(archivo, 0, SEEK_SET);
+    if (largo <= 0) {
+        fclose(archivo);
+        return NULL;
+    }
+
+    void* contenido = malloc(largo);
+    if (!contenido || fread(contenido, 1, largo, archivo) != (size_t)largo) {
+        free(contenido);
+        fclose(archivo);
+        return NULL;
+    }
+    fclose(archivo);
+
+    *size = (int)largo;
+    return contenido;
+}
+
+static bool misma_version(script_en_disco_t* version, struct stat* info) {
+    return version->size == info->st_size
+        && version->mtime.tv_sec == info->st_mtim.tv_sec
+        && version->mtime.tv_nsec == info->st_mtim.tv_nsec;
+}
+
+void cache_scripts_iniciar(master_t* master) {
+    pthread_mutex_init(&master->scripts_mutex, NULL);
+    master->scripts_por_hash = dictionary_create();
+    master->hash_por_path = dictionary_create();
+}
+
+static void script_cacheado_destruir(script_cacheado_t* script) {
+    free(script->contenido);
+    free(script);
+}
+
+static void soltar_script(master_t* master, script_cacheado_t* script) {
+    // ⚠️ Llamar con scripts_mutex tomado
+    if (--script->referencias == 0) {
+        dictionary_remove(master->scripts_por_hash, script->hash);
+        script_cacheado_destruir(script);
+    }
+}
+
+/**
+ * @brief Devuelve la versión actual del script de un path, con una referencia tomada
+ *
+ * Se llama al recibir NEW_QUERY, SIN main_mutex tomado: el stat, la lectura del archivo
+ * y el hash se hacen fuera de los mutex y solo la consulta/actualización de la caché toma
+ * scripts_mutex. El stat se toma antes de leer, así una escritura concurrente se detecta
+ * en la próxima NEW_QUERY. La referencia se devuelve con cache_scripts_soltar (lo hace
+ * query_destruir). Devuelve NULL si no hay PATH_QUERIES o no se pudo leer el script.
+ */
+script_cacheado_t* cache_scripts_cargar(master_t* master, const char* path) {
+    if (!master || !path || master->config->path_queries[0] == '\0') return NULL;
+
+    char* ruta = string_from_format("%s/%s", master->config->path_queries, path);
+    struct stat info;
+    if (stat(ruta, &info) != 0) {
+        log_warning(master->logger, "[SCRIPTS] No se pudo abrir %s, se enviará solo el path", ruta);
+        free(ruta);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&master->scripts_mutex);
+    script_en_disco_t* version = dictionary_get(master->hash_por_path, (char*)path);
+    if (version && misma_version(version, &info)) {
+        script_cacheado_t* script = dictionary_get(master->scripts_por_hash, version->hash);
+        script->referencias++;
+        pthread_mutex_unlock(&master->scripts_mutex);
+        free(ruta);
+        return script;
+    }
+    pthread_mutex_unlock(&master->scripts_mutex);
+
+    int size = 0;
+    void* contenido = leer_script(master, ruta, &size);
+    free(ruta);
+    if (!contenido) return NULL;
+
+    char hash[HASH_SCRIPT_SIZE];
+    if (!calcular_md5(contenido, size, hash)) {
+        log_warning(master->logger, "[SCRIPTS] Error calculando el hash de %s", path);
+        free(contenido);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&master->scripts_mutex);
+    script_cacheado_t* script = dictionary_get(master->scripts_por_hash, hash);
+    if (!script) {
+        script = malloc(sizeof(script_cacheado_t));
+        memcpy(script->hash, hash, HASH_SCRIPT_SIZE);
+        script->contenido = contenido;
+        script->size = size;
+        script->referencias = 0;
+        dictionary_put(master->scripts_por_hash, hash, script);
+        contenido = NULL;
+    }
+
+    // El path pasa a apuntar a esta versión: la anterior pierde la referencia del path
+    // y se libera cuando terminen las queries que la fijaron
+    version = dictionary_get(master->hash_por_path, (char*)path);
+    if (!version) {
+        version = malloc(sizeof(script_en_disco_t));
+        version->hash[0] = '\0';
+        dictionary_put(master->hash_por_path, (char*)path, version);
+    }
+    if (strcmp(version->hash, hash) != 0) {
+        script->referencias++;
+        script_cacheado_t* anterior = version->hash[0] ? dictionary_get(master->scripts_por_hash, version->hash) : NULL;
+        if (anterior) soltar_script(master, anterior);
+        memcpy(version->hash, hash, HASH_SCRIPT_SIZE);
+    }
+    version->mtime = info.st_mtim;
+    version->size = info.st_size;
+
+    script->referencias++;
+    pthread_mutex_unlock(&master->scripts_mutex);
+
+    // Otro path (u otra versión) con el mismo contenido ya estaba en la caché
+    free(contenido);
+
+    log_debug(master->logger, "[SCRIPTS] Script %s en caché (hash %s, %d bytes)", path, hash, size);
+    return script;
+}
+
+void cache_scripts_soltar(master_t* master, script_cacheado_t* script) {
+    if (!master || !script) return;
+
+    pthread_mutex_lock(&master->scripts_mutex);
+    soltar_script(master, script);
+    pthread_mutex_unlock(&master->scripts_mutex);
+}
+
+/**
+ * @brief Libera la caché completa al cerrar el Master
+ *
+ * Se llama después de query_pool_destruir: las queries que quedaban ya no existen,
+ * así que se liberan todos los scripts sin mirar las referencias.
+ */
+void cache_scripts_destruir(master_t* master) {
+    if (!master) return;
+
+    if (master->scripts_por_hash) {
+        dictionary_destroy_and_destroy_elements(master->scripts_por_hash, (void*)script_cacheado_destruir);
+        master->scripts_por_hash = NULL;
+    }
+    if (master->hash_por_path) {
+        dictionary_destroy_and_destroy_elements(master->hash_por_path, free);
+        master->hash_por_path = NULL;
+    }
+    pthread_mutex_destroy(&master->scripts_mutex);
+}
+
+/**
+ * @brief Prioridad que viaja en EXECUTE_QUERY para que el worker etiquete sus FS_*
+ *
+ * Solo en PRIORIDADES el Master ordena por query->priority. En FIFO es el id (orden de
+ * llegada) y EDF ordena por deadline: en los dos se manda -1 para que el Storage no
+ * ordene distinto que el Master.
+ */
+static int prioridad_para_worker(master_t* master, query_t* query) {
+    if (master->config->algoritmo_planificacion != ALGORITHM_PRIORIDADES) return -1;
+    return query->priority;
+}
+
+/**
+ * @brief Arma el payload de EXECUTE_QUERY para un worker
+ *
+ * Punto único donde se serializa EXECUTE_QUERY. Cada extensión va solo a los workers
+ * que la anunciaron en el handshake: con CAPACIDAD_CACHE_SCRIPTS se agrega el hash del
+ * script (y el contenido solo si todavía no lo tienen); con CAPACIDAD_PRIORIDAD, la
+ * prioridad actual de la query, que el worker propaga en sus pedidos FS_* al Storage.
+ * Si el contenido va inline, su hash queda en hash_inline (si no, hash_inline queda
+ * vacío): el caller lo registra con registrar_script_enviado SOLO si el envío salió
+ * bien, porque si falla el worker puede seguir conectado y no tiene el script.
+ * ⚠️ Llamar con mutex tomado
+ */
+void* armar_execute_query(master_t* master, worker_t* worker, query_t* query, char hash_inline[HASH_SCRIPT_SIZE], int* size) {
+    hash_inline[0] = '\0';
+    if (!master || !worker || !query) return NULL;
+
+    int prioridad = prioridad_para_worker(master, query);
+    const int* con_prioridad = (worker->capacidades & CAPACIDAD_PRIORIDAD) ? &prioridad : NULL;
+
+    if (!(worker->capacidades & CAPACIDAD_CACHE_SCRIPTS)) {
+        if (con_prioridad) {
+            return serializar_execute_query_con_prioridad(query->id, query->path_query, query->pc, prioridad, size);
+        }
+        return serializar_execute_query(query->id, query->path_query, query->pc, size);
+    }
+
+    // La versión fijada por la query: su referencia la mantiene viva sin tomar scripts_mutex
+    script_cacheado_t* script = query->script;
+    if (!script) {
+        return serializar_execute_query_con_script(query->id, query->path_query, query->pc,
+                                                   NULL, NULL, 0, con_prioridad, size);
+    }
+
+    if (dictionary_has_key(worker->scripts, script->hash)) {
+        return serializar_execute_query_con_script(query->id, query->path_query, query->pc,
+                                                   script->hash, NULL, 0, con_prioridad, size);
+    }
+
+    memcpy(hash_inline, script->hash, HASH_SCRIPT_SIZE);
+    log_debug(master->logger, "[SCRIPTS] Enviando script %s inline al Worker %s", script->hash, worker->id);
+    return serializar_execute_query_con_script(query->id, query->path_query, query->pc,
+                                               script->hash, script->contenido, script->size, con_prioridad, size);
+}
+
+/**
+ * @brief Marca que el worker ya tiene el script, después de un EXECUTE_QUERY enviado OK
+ *
+ * Se llama SIN main_mutex tomado. Busca el worker por id porque pudo desconectarse
+ * mientras se enviaba el paquete.
+ */
+void registrar_script_enviado(master_t* master, char* worker_id, const char* hash) {
+    if (!master || !worker_id || !hash || hash[0] == '\0') return;
+
+    pthread_mutex_lock(&master->main_mutex);
+    worker_t* worker = buscar_worker_por_id_directo(master, worker_id);
+    if (worker) {
+        dictionary_put(worker->scripts, (char*)hash, NULL);
+    }
+    pthread_mutex_unlock(&master->main_mutex);
+}
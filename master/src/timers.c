@@ -0,0 +1,178 @@
+#include "master.h"
+#include <errno.h>
+
+// ========== RUEDA DE TIMERS ==========
+// Una única thread bloqueada en un timerfd avanza la rueda cada TIMER_TICK_MS.
+// Aging, heartbeats y timeouts de desalojo se programan acá en lugar de tener
+// cada uno su propio hilo con sleep.
+
+uint64_t tiempo_actual_ms(void) {
+    struct timespec ahora;
+    clock_gettime(CLOCK_MONOTONIC, &ahora);
+    return (uint64_t)ahora.tv_sec * 1000 + ahora.tv_nsec / 1000000;
+}
+
+static void insertar_entry(timer_wheel_t* wheel, timer_entry_t* entry) {
+    // ⚠️ Llamar con wheel->mutex tomado
+    int slot = entry->vencimiento % TIMER_WHEEL_SLOTS;
+    entry->siguiente = wheel->slots[slot];
+    wheel->slots[slot] = entry;
+}
+
+static void liberar_entry(timer_entry_t* entry) {
+    if (entry->liberar_arg) free(entry->arg);
+    free(entry);
+}
+
+static void procesar_tick(timer_wheel_t* wheel) {
+    timer_entry_t* vencidos = NULL;
+
+    pthread_mutex_lock(&wheel->mutex);
+    wheel->tick_actual++;
+    uint64_t tick = wheel->tick_actual;
+
+    // Sacar del slot solo los que vencen en esta vuelta (los demás esperan vueltas futuras)
+    timer_entry_t** actual = &wheel->slots[tick % TIMER_WHEEL_SLOTS];
+    while (*actual) {
+        timer_entry_t* entry = *actual;
+        if (entry->vencimiento <= tick) {
+            *actual = entry->siguiente;
+            entry->siguiente = vencidos;
+            vencidos = entry;
+        } else {
+            actual = &entry->siguiente;
+        }
+    }
+    pthread_mutex_unlock(&wheel->mutex);
+
+    // Los callbacks corren sin el mutex de la rueda: pueden tomar main_mutex y programar timers
+    while (vencidos) {
+        timer_entry_t* entry = vencidos;
+        vencidos = entry->siguiente;
+
+        entry->callback(entry->arg);
+
+        if (entry->periodo_ticks > 0 && wheel->activa) {
+            pthread_mutex_lock(&wheel->mutex);
+            entry->vencimiento = wheel->tick_actual + entry->periodo_ticks;
+            insertar_entry(wheel, entry);
+            pthread_mutex_unlock(&wheel->mutex);
+        } else {
+            liberar_entry(entry);
+        }
+    }
+}
+
+static void* funcion_hilo_timers(void* arg) {
+    timer_wheel_t* wheel = (timer_wheel_t*)arg;
+
+    while (wheel->activa) {
+        uint64_t expiraciones = 0;
+        ssize_t leidos = read(wheel->timerfd, &expiraciones, sizeof(expiraciones));
+        if (leidos != sizeof(expiraciones)) {
+            if (leidos < 0 && errno != EINTR) break;
+            continue;
+        }
+
+        // Si un callback tardó más de un tick, el timerfd acumula expiraciones: no se pierde ninguna
+        for (uint64_t i = 0; i < expiraciones && wheel->activa; i++) {
+            procesar_tick(wheel);
+        }
+    }
+
+    return NULL;
+}
+
+timer_wheel_t* timer_wheel_crear(void) {
+    timer_wheel_t* wheel = calloc(1, sizeof(timer_wheel_t));
+    if (!wheel) return NULL;
+
+    wheel->timerfd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if (wheel->timerfd < 0) {
+        free(wheel);
+        return NULL;
+    }
+
+    struct itimerspec periodo;
+    periodo.it_interval.tv_sec = TIMER_TICK_MS / 1000;
+    periodo.it_interval.tv_nsec = (TIMER_TICK_MS % 1000) * 1000000L;
+    periodo.it_value = periodo.it_interval;
+
+    if (timerfd_settime(wheel->timerfd, 0, &periodo, NULL) < 0) {
+        close(wheel->timerfd);
+        free(wheel);
+        return NULL;
+    }
+
+    pthread_mutex_init(&wheel->mutex, NULL);
+    return wheel;
+}
+
+bool timer_wheel_iniciar(timer_wheel_t* wheel) {
+    if (!wheel) return false;
+
+    wheel->activa = true;
+    if (pthread_create(&wheel->thread, NULL, funcion_hilo_timers, wheel) != 0) {
+        wheel->activa = false;
+        return false;
+    }
+    return true;
+}
+
+void timer_wheel_detener(timer_wheel_t* wheel) {
+    if (!wheel || !wheel->activa) return;
+
+    // El read() del timerfd vuelve como mucho en un tick, no hace falta despertar la thread
+    wheel->activa = false;
+    pthread_join(wheel->thread, NULL);
+}
+
+void timer_wheel_destruir(timer_wheel_t* wheel) {
+    if (!wheel) return;
+
+    timer_wheel_detener(wheel);
+
+    for (int i = 0; i < TIMER_WHEEL_SLOTS; i++) {
+        timer_entry_t* entry = wheel->slots[i];
+        while (entry) {
+            timer_entry_t* siguiente = entry->siguiente;
+            liberar_entry(entry);
+            entry = siguiente;
+        }
+    }
+
+    close(wheel->timerfd);
+    pthread_mutex_destroy(&wheel->mutex);
+    free(wheel);
+}
+
+/**
+ * @brief Programa un callback en la rueda de timers
+ *
+ * Puede llamarse con master->main_mutex tomado: la rueda nunca toma main_mutex
+ * mientras tiene su propio mutex.
+ *
+ * @param delay_ms Tiempo hasta el primer disparo (redondeado hacia arriba a ticks)
+ * @param periodo_ms Período de repetición, 0 para un timer one-shot
+ * @param liberar_arg Si es true, la rueda hace free(arg) cuando el timer deja de existir
+ */
+void timer_programar(timer_wheel_t* wheel, int delay_ms, int periodo_ms, timer_callback_t callback, void* arg, bool liberar_arg) {
+    if (!wheel || !callback) return;
+
+    timer_entry_t* entry = malloc(sizeof(timer_entry_t));
+    if (!entry) {
+        if (liberar_arg) free(arg);
+        return;
+    }
+
+    uint64_t delay_ticks = delay_ms > 0 ? (delay_ms + TIMER_TICK_MS - 1) / TIMER_TICK_MS : 1;
+    entry->periodo_ticks = periodo_ms > 0 ? (periodo_ms + TIMER_TICK_MS - 1) / TIMER_TICK_MS : 0;
+    entry->callback = callback;
+    entry->arg = arg;
+    entry->liberar_arg = liberar_arg;
+
+    pthread_mutex_lock(&wheel->mutex);
+    entry->vencimiento = wheel->tick_actual + delay_ticks;
+    insertar_entry(wheel, entry);
+    pthread_mutex_unlock(&wheel->mutex);
+}
@@ -2,14 +2,16 @@
 
 int main(int argc, char* argv[]) {
     // Verificar argumentos de línea de comandos
-    if (argc != 4) {
-        printf("Uso: %s [archivo_config] [archivo_query] [prioridad]\n", argv[0]);
+    if (argc < 4 || argc > 6) {
+        printf("Uso: %s [archivo_config] [archivo_query] [prioridad] [deadline_ms] [costo_ms]\n", argv[0]);
         return EXIT_FAILURE;
     }
 
     char* config_path = argv[1];
     char* archivo_query = argv[2];
     int prioridad = atoi(argv[3]);
+    int deadline_ms = argc > 4 ? atoi(argv[4]) : 0;
+    int costo_ms = argc > 5 ? atoi(argv[5]) : 0;
 
     // Validar prioridad
     if (prioridad < 0) {
@@ -17,8 +19,13 @@ int main(int argc, char* argv[]) {
         return EXIT_FAILURE;
     }
 
+    if (deadline_ms < 0 || costo_ms < 0) {
+        printf("Error: El deadline y el costo deben ser mayores o iguales a 0\n");
+        return EXIT_FAILURE;
+    }
+
     // Crear instancia del Query Control
-    query_control_t* qc = query_control_crear(config_path, archivo_query, prioridad);
+    query_control_t* qc = query_control_crear(config_path, archivo_query, prioridad, deadline_ms, costo_ms);
     if (!qc) {
         printf("Error: No se pudo crear el Query Control\n");
         return EXIT_FAILURE;
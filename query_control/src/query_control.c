@@ -4,7 +4,7 @@
 
 // ========== FUNCIONES PRINCIPALES ==========
 
-query_control_t* query_control_crear(char* config_path, char* archivo_query, int prioridad) {
+query_control_t* query_control_crear(char* config_path, char* archivo_query, int prioridad, int deadline_ms, int costo_ms) {
     query_control_t* qc = malloc(sizeof(query_control_t));
     if (!qc) {
         printf("[ERROR] No se pudo asignar memoria para Query Control\n");
@@ -32,8 +32,12 @@ query_control_t* query_control_crear(char* config_path, char* archivo_query, int
     qc->query_id = 0;
     qc->archivo_query = strdup(archivo_query);
     qc->prioridad = prioridad;
+    // Los argumentos de línea de comandos (> 0) tienen precedencia sobre el config
+    qc->deadline_ms = deadline_ms > 0 ? deadline_ms : qc->config->deadline_ms;
+    qc->costo_ms = costo_ms > 0 ? costo_ms : qc->config->costo_ms;
     qc->query_finished = false;
     qc->connected = false;
+    qc->reintentos = 0;
     pthread_mutex_init(&qc->mutex, NULL);
 
     log_info(qc->logger, "[QUERY_CONTROL] Query Control inicializado para archivo %s con prioridad %d", 
@@ -188,7 +192,10 @@ bool query_control_enviar_query(query_control_t* qc) {
     // Usar funciones de serialización de utils (igual que Master/Worker)
     // Se envía el NOMBRE del archivo (no su contenido), el Worker lo leerá
     int payload_size = 0;
-    void* payload = serializar_new_query(qc->archivo_query, qc->prioridad, &payload_size);
+    // Con deadline se agregan [deadline_ms][costo_ms] al final (el Master los usa bajo EDF)
+    void* payload = qc->deadline_ms > 0
+        ? serializar_new_query_con_deadline(qc->archivo_query, qc->prioridad, qc->deadline_ms, qc->costo_ms, &payload_size)
+        : serializar_new_query(qc->archivo_query, qc->prioridad, &payload_size);
     if (!payload) {
         log_error(qc->logger, "[QUERY_CONTROL] Error serializando NEW_QUERY");
         return false;
@@ -264,6 +271,19 @@ void query_control_procesar_respuestas(query_control_t* qc) {
                 }
                 break;
             }
+            case QUERY_RECHAZADA: {
+                error_code_t codigo_error = ERROR_GENERAL;
+                int retry_after_ms = 0;
+                char* motivo = NULL;
+                if (payload && size > 0) {
+                    deserializar_query_rechazada(payload, &codigo_error, &retry_after_ms, &motivo);
+                    manejar_query_rechazada(qc, codigo_error, retry_after_ms, motivo);
+                    free(motivo);
+                } else {
+                    log_error(qc->logger, "[QUERY_CONTROL] Error deserializando QUERY_RECHAZADA");
+                }
+                break;
+            }
             case ERROR: {
                 uint64_t query_id = 0;
                 if (payload && size >= sizeof(uint64_t)) {
@@ -363,6 +383,15 @@ query_control_config_t* cargar_config_qc(char* config_path) {
                         config_get_string_value(config, "QUERIES_DIR") : ".";
     qc_config->queries_dir = strdup(queries_dir);
 
+    qc_config->reintentos_admision = config_has_property(config, "REINTENTOS_ADMISION") ?
+                                    config_get_int_value(config, "REINTENTOS_ADMISION") : 5;
+
+    // Deadline relativo y costo estimado para EDF (0 = sin deadline)
+    qc_config->deadline_ms = config_has_property(config, "DEADLINE_MS") ?
+                            config_get_int_value(config, "DEADLINE_MS") : 0;
+    qc_config->costo_ms = config_has_property(config, "COSTO_ESTIMADO") ?
+                         config_get_int_value(config, "COSTO_ESTIMADO") : 0;
+
     config_destroy(config);
     return qc_config;
 }
@@ -454,6 +483,30 @@ void manejar_error(query_control_t* qc, uint64_t query_id) {
     log_query_finalizada(qc->logger, "Error en la ejecución");
 }
 
+void manejar_query_rechazada(query_control_t* qc, error_code_t codigo_error, int retry_after_ms, char* motivo) {
+    if (!qc) return;
+
+    log_warning(qc->logger, "[QUERY_CONTROL] Query rechazada por el Master (código %d): %s", codigo_error, motivo);
+
+    // El Master no registró la query: se puede reenviar por la misma conexión
+    if (qc->reintentos < qc->config->reintentos_admision) {
+        qc->reintentos++;
+        log_info(qc->logger, "[QUERY_CONTROL] Reintento %d/%d en %d ms",
+                 qc->reintentos, qc->config->reintentos_admision, retry_after_ms);
+        usleep(retry_after_ms * 1000);
+
+        if (query_control_enviar_query(qc)) {
+            return;
+        }
+    }
+
+    pthread_mutex_lock(&qc->mutex);
+    qc->query_finished = true;
+    pthread_mutex_unlock(&qc->mutex);
+
+    log_query_finalizada(qc->logger, "Rechazada por el Master");
+}
+
 // ========== FUNCIONES DE LOGGING ==========
 
 void log_conexion_exitosa(t_log* logger, char* ip, int puerto) {
@@ -30,6 +30,9 @@ typedef struct {
     char* log_level;
     char* path_logs;
     char* queries_dir; // directorio donde buscar archivos de query (opcional)
+    int reintentos_admision; // veces que se reenvía la query si el Master la rechaza por cupo
+    int deadline_ms;         // DEADLINE_MS, se usa si no se pasa [deadline_ms] por línea de comandos
+    int costo_ms;            // COSTO_ESTIMADO, idem para [costo_ms]
 } query_control_config_t;
 
 // Estructura principal del Query Control
@@ -40,13 +43,16 @@ typedef struct {
     uint64_t query_id;
     char* archivo_query;
     int prioridad;
+    int deadline_ms;   // deadline relativo para EDF (0 = sin deadline)
+    int costo_ms;      // costo estimado informado al Master (0 = desconocido)
     bool query_finished;
     bool connected;
+    int reintentos;    // reenvíos hechos tras QUERY_RECHAZADA
     pthread_mutex_t mutex;
 } query_control_t;
 
 // Funciones principales
-query_control_t* query_control_crear(char* config_path, char* archivo_query, int prioridad);
+query_control_t* query_control_crear(char* config_path, char* archivo_query, int prioridad, int deadline_ms, int costo_ms);
 void query_control_destruir(query_control_t* qc);
 bool query_control_conectar(query_control_t* qc);
 void query_control_desconectar(query_control_t* qc);
@@ -63,6 +69,7 @@ void manejar_new_query_ack(query_control_t* qc, uint64_t query_id);
 void manejar_query_finished(query_control_t* qc, uint64_t query_id);
 void manejar_read_result(query_control_t* qc, uint64_t query_id, char* origen, void* data, int data_size);
 void manejar_error(query_control_t* qc, uint64_t query_id);
+void manejar_query_rechazada(query_control_t* qc, error_code_t codigo_error, int retry_after_ms, char* motivo);
 
 // Funciones de logging específicas del enunciado
 void log_conexion_exitosa(t_log* logger, char* ip, int puerto);
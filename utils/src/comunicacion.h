@@ -63,10 +63,26 @@ typedef enum {
 
     // -- Contenido de Payloads --
     BLOCK_CONTENT,      // Storage -> Worker
-    BLOCK_SIZE_RESPONSE // Storage -> Worker
+    BLOCK_SIZE_RESPONSE, // Storage -> Worker
+
+    // -- Supervisión Master <-> Worker --
+    HEARTBEAT,          // Master -> Worker (seq)
+    HEARTBEAT_ACK,      // Worker -> Master (seq, [query_id, pc] de la query en ejecución)
+
+    // -- Control de admisión --
+    QUERY_RECHAZADA,    // Master -> QC (código de error, retry-after, motivo)
+
+    // -- Caché de scripts --
+    SCRIPT_FALTANTE     // Worker -> Master (query_id, hash): pide reenviar el script inline
 
 } op_code;
 
+// -- Capacidades que un Worker anuncia en HANDSHAKE_WORKER (bitmask) --
+// El Master solo usa una extensión del protocolo con los Workers que la anunciaron
+#define CAPACIDAD_HEARTBEAT      (1 << 0)   // Contesta HEARTBEAT con HEARTBEAT_ACK
+#define CAPACIDAD_CACHE_SCRIPTS  (1 << 1)   // Acepta EXECUTE_QUERY con hash/script inline
+#define CAPACIDAD_PRIORIDAD      (1 << 2)   // Acepta EXECUTE_QUERY con la prioridad al final
+
 // -- Respuestas con código de error --
 #define ERROR_RESPONSE ERROR
 
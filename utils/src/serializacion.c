@@ -32,6 +32,39 @@ void deserializar_new_query(void* buffer, char** path, int* prioridad) {
     memcpy(prioridad, buffer + offset, sizeof(int));
 }
 
+// --- NEW_QUERY con deadline (QC -> Master) ---
+// Payload: [tamanio_path (int)] [path (char*)] [prioridad (int)] [deadline_ms (int)] [costo_ms (int)]
+void* serializar_new_query_con_deadline(const char* path, int prioridad, int deadline_ms, int costo_ms, int* size) {
+    int size_path = strlen(path) + 1;
+    *size = sizeof(int) + size_path + sizeof(int) * 3;
+
+    void* buffer = malloc(*size);
+    int offset = 0;
+
+    memcpy(buffer + offset, &size_path, sizeof(int)); offset += sizeof(int);
+    memcpy(buffer + offset, path, size_path); offset += size_path;
+    memcpy(buffer + offset, &prioridad, sizeof(int)); offset += sizeof(int);
+    memcpy(buffer + offset, &deadline_ms, sizeof(int)); offset += sizeof(int);
+    memcpy(buffer + offset, &costo_ms, sizeof(int));
+
+    return buffer;
+}
+
+void deserializar_new_query_con_deadline(void* buffer, int size, char** path, int* prioridad, int* deadline_ms, int* costo_ms) {
+    int size_path;
+    memcpy(&size_path, buffer, sizeof(int));
+
+    deserializar_new_query(buffer, path, prioridad);
+
+    int offset = sizeof(int) + size_path + sizeof(int);
+    *deadline_ms = 0;
+    *costo_ms = 0;
+    if (size >= offset + (int)sizeof(int) * 2) {
+        memcpy(deadline_ms, buffer + offset, sizeof(int)); offset += sizeof(int);
+        memcpy(costo_ms, buffer + offset, sizeof(int));
+    }
+}
+
 // --- NEW_QUERY_ACK y QUERY_FINISHED ---
 // Payload: [id (uint64_t)]
 void* serializar_ack_con_id(uint64_t id, int* size) {
@@ -79,6 +112,145 @@ void deserializar_execute_query(void* buffer, uint64_t* id, char** path, uint32_
     memcpy(pc, buffer + offset, sizeof(uint32_t));
 }
 
+// --- EXECUTE_QUERY con prioridad (Master -> Worker) ---
+// Payload: [EXECUTE_QUERY] [prioridad (int)]
+void* serializar_execute_query_con_prioridad(uint64_t id, const char* path, uint32_t pc, int prioridad, int* size) {
+    int size_base = 0;
+    void* base = serializar_execute_query(id, path, pc, &size_base);
+
+    *size = size_base + sizeof(int);
+    void* buffer = malloc(*size);
+    memcpy(buffer, base, size_base);
+    memcpy(buffer + size_base, &prioridad, sizeof(int));
+
+    free(base);
+    return buffer;
+}
+
+void deserializar_execute_query_con_prioridad(void* buffer, int size, uint64_t* id, char** path, uint32_t* pc, int* prioridad) {
+    deserializar_execute_query(buffer, id, path, pc);
+
+    int size_path;
+    memcpy(&size_path, buffer + sizeof(uint64_t), sizeof(int));
+    int offset = sizeof(uint64_t) + sizeof(int) + size_path + sizeof(uint32_t);
+
+    *prioridad = -1;
+    if (size >= offset + (int)sizeof(int)) {
+        memcpy(prioridad, buffer + offset, sizeof(int));
+    }
+}
+
+// --- EXECUTE_QUERY con script (Master -> Worker) ---
+// Payload: [EXECUTE_QUERY] [hash (HASH_SCRIPT_SIZE)] [size_script (int)] [script (size_script bytes)] [prioridad (int), opcional]
+void* serializar_execute_query_con_script(uint64_t id, const char* path, uint32_t pc, const char* hash,
+                                          const void* script, int size_script, const int* prioridad, int* size) {
+    int size_base = 0;
+    void* base = serializar_execute_query(id, path, pc, &size_base);
+    if (!script) size_script = 0;
+
+    *size = size_base + HASH_SCRIPT_SIZE + sizeof(int) + size_script + (prioridad ? sizeof(int) : 0);
+    void* buffer = malloc(*size);
+    int offset = 0;
+
+    memcpy(buffer + offset, base, size_base);
+    offset += size_base;
+    memset(buffer + offset, 0, HASH_SCRIPT_SIZE);
+    if (hash) strncpy(buffer + offset, hash, HASH_SCRIPT_SIZE - 1);
+    offset += HASH_SCRIPT_SIZE;
+    memcpy(buffer + offset, &size_script, sizeof(int));
+    offset += sizeof(int);
+    if (size_script > 0) {
+        memcpy(buffer + offset, script, size_script);
+        offset += size_script;
+    }
+    if (prioridad) memcpy(buffer + offset, prioridad, sizeof(int));
+
+    free(base);
+    return buffer;
+}
+
+void deserializar_execute_query_con_script(void* buffer, int size, uint64_t* id, char** path, uint32_t* pc,
+                                           char** hash, void** script, int* size_script, int* prioridad) {
+    deserializar_execute_query(buffer, id, path, pc);
+
+    int size_path;
+    memcpy(&size_path, buffer + sizeof(uint64_t), sizeof(int));
+    int offset = sizeof(uint64_t) + sizeof(int) + size_path + sizeof(uint32_t);
+
+    *hash = NULL;
+    *script = NULL;
+    *size_script = 0;
+    *prioridad = -1;
+    if (size < offset + HASH_SCRIPT_SIZE + (int)sizeof(int)) return;
+
+    *hash = malloc(HASH_SCRIPT_SIZE);
+    memcpy(*hash, buffer + offset, HASH_SCRIPT_SIZE);
+    (*hash)[HASH_SCRIPT_SIZE - 1] = '\0';
+    offset += HASH_SCRIPT_SIZE;
+    memcpy(size_script, buffer + offset, sizeof(int));
+    offset += sizeof(int);
+    if (*size_script > 0 && size >= offset + *size_script) {
+        *script = malloc(*size_script);
+        memcpy(*script, buffer + offset, *size_script);
+        offset += *size_script;
+    } else {
+        *size_script = 0;
+    }
+    if (size >= offset + (int)sizeof(int)) {
+        memcpy(prioridad, buffer + offset, sizeof(int));
+    }
+}
+
+// --- HANDSHAKE_WORKER (Worker -> Master) ---
+// Payload: [id (int)] o [id (int)] [capacidades (int)] [cantidad (int)] [hash (HASH_SCRIPT_SIZE)] * cantidad
+void* serializar_handshake_worker(int id, int capacidades, char** hashes, int cantidad, int* size) {
+    if (!hashes) cantidad = 0;
+    *size = sizeof(int);
+    if (capacidades != 0) *size += sizeof(int) * 2 + cantidad * HASH_SCRIPT_SIZE;
+
+    void* buffer = calloc(1, *size);
+    int offset = 0;
+
+    memcpy(buffer + offset, &id, sizeof(int));
+    offset += sizeof(int);
+    if (capacidades == 0) return buffer;
+
+    memcpy(buffer + offset, &capacidades, sizeof(int));
+    offset += sizeof(int);
+    memcpy(buffer + offset, &cantidad, sizeof(int));
+    offset += sizeof(int);
+    for (int i = 0; i < cantidad; i++) {
+        strncpy(buffer + offset, hashes[i], HASH_SCRIPT_SIZE - 1);
+        offset += HASH_SCRIPT_SIZE;
+    }
+
+    return buffer;
+}
+
+void deserializar_handshake_worker(void* buffer, int size, int* id, int* capacidades, char*** hashes, int* cantidad) {
+    memcpy(id, buffer, sizeof(int));
+    *capacidades = 0;
+    *hashes = NULL;
+    *cantidad = 0;
+
+    if (size < (int)sizeof(int) * 3) return;
+
+    memcpy(capacidades, buffer + sizeof(int), sizeof(int));
+    int anunciados;
+    memcpy(&anunciados, buffer + sizeof(int) * 2, sizeof(int));
+    int offset = sizeof(int) * 3;
+    if (anunciados < 0 || anunciados > (size - offset) / HASH_SCRIPT_SIZE) {
+        anunciados = (size - offset) / HASH_SCRIPT_SIZE;
+    }
+
+    *hashes = malloc(sizeof(char*) * (anunciados > 0 ? anunciados : 1));
+    for (int i = 0; i < anunciados; i++) {
+        (*hashes)[i] = strndup(buffer + offset, HASH_SCRIPT_SIZE - 1);
+        offset += HASH_SCRIPT_SIZE;
+    }
+    *cantidad = anunciados;
+}
+
 // --- BLOCK_SIZE_RESPONSE (Storage -> Worker) ---
 // Payload: [block_size (int)]
 void* serializar_respuesta_block_size(int block_size, int* size) {
@@ -287,6 +459,114 @@ void deserializar_read_block(void* buffer, char** file, char** tag, int* block_n
     memcpy(block_num, buffer + offset, sizeof(int));
 }
 
+// --- Contexto opcional de los FS_* (Worker -> Storage) ---
+// Payload: [payload FS_* de siempre] [query_id (uint64_t)] [prioridad (int)]
+#define CONTEXTO_FS_SIZE (int)(sizeof(uint64_t) + sizeof(int))
+
+static void* agregar_contexto_fs(void* base, int size_base, const contexto_fs_t* contexto, int* size) {
+    if (!contexto) {
+        *size = size_base;
+        return base;
+    }
+
+    *size = size_base + CONTEXTO_FS_SIZE;
+    void* buffer = realloc(base, *size);
+    memcpy(buffer + size_base, &contexto->query_id, sizeof(uint64_t));
+    memcpy(buffer + size_base + sizeof(uint64_t), &contexto->prioridad, sizeof(int));
+    return buffer;
+}
+
+// Largo de un campo [size (int)] [bytes] que empieza en offset
+static int largo_campo(void* buffer, int offset) {
+    int size_campo;
+    memcpy(&size_campo, buffer + offset, sizeof(int));
+    return sizeof(int) + size_campo;
+}
+
+static void leer_contexto_fs(void* buffer, int size, int offset, contexto_fs_t* contexto) {
+    contexto->query_id = 0;
+    contexto->prioridad = -1;
+    if (size >= offset + CONTEXTO_FS_SIZE) {
+        memcpy(&contexto->query_id, buffer + offset, sizeof(uint64_t));
+        memcpy(&contexto->prioridad, buffer + offset + sizeof(uint64_t), sizeof(int));
+    }
+}
+
+void* serializar_file_tag_con_contexto(const char* file, const char* tag, const contexto_fs_t* contexto, int* size) {
+    int size_base = 0;
+    void* base = serializar_file_tag(file, tag, &size_base);
+    return agregar_contexto_fs(base, size_base, contexto, size);
+}
+
+void deserializar_file_tag_con_contexto(void* buffer, int size, char** file, char** tag, contexto_fs_t* contexto) {
+    deserializar_file_tag(buffer, file, tag);
+    int offset = largo_campo(buffer, 0);
+    offset += largo_campo(buffer, offset);
+    leer_contexto_fs(buffer, size, offset, contexto);
+}
+
+void* serializar_truncate_con_contexto(const char* file, const char* tag, int new_size, const contexto_fs_t* contexto, int* size) {
+    int size_base = 0;
+    void* base = serializar_truncate(file, tag, new_size, &size_base);
+    return agregar_contexto_fs(base, size_base, contexto, size);
+}
+
+void deserializar_truncate_con_contexto(void* buffer, int size, char** file, char** tag, int* new_size, contexto_fs_t* contexto) {
+    deserializar_truncate(buffer, file, tag, new_size);
+    int offset = largo_campo(buffer, 0);
+    offset += largo_campo(buffer, offset);
+    offset += sizeof(int);
+    leer_contexto_fs(buffer, size, offset, contexto);
+}
+
+void* serializar_write_block_con_contexto(const char* file, const char* tag, int block_num, void* data, int data_size,
+                                          const contexto_fs_t* contexto, int* size) {
+    int size_base = 0;
+    void* base = serializar_write_block(file, tag, block_num, data, data_size, &size_base);
+    return agregar_contexto_fs(base, size_base, contexto, size);
+}
+
+void deserializar_write_block_con_contexto(void* buffer, int size, char** file, char** tag, int* block_num,
+                                           void** data, int* data_size, contexto_fs_t* contexto) {
+    deserializar_write_block(buffer, file, tag, block_num, data, data_size);
+    int offset = largo_campo(buffer, 0);
+    offset += largo_campo(buffer, offset);
+    offset += sizeof(int);
+    offset += largo_campo(buffer, offset);
+    leer_contexto_fs(buffer, size, offset, contexto);
+}
+
+void* serializar_read_block_con_contexto(const char* file, const char* tag, int block_num, const contexto_fs_t* contexto, int* size) {
+    int size_base = 0;
+    void* base = serializar_read_block(file, tag, block_num, &size_base);
+    return agregar_contexto_fs(base, size_base, contexto, size);
+}
+
+void deserializar_read_block_con_contexto(void* buffer, int size, char** file, char** tag, int* block_num, contexto_fs_t* contexto) {
+    deserializar_read_block(buffer, file, tag, block_num);
+    int offset = largo_campo(buffer, 0);
+    offset += largo_campo(buffer, offset);
+    offset += sizeof(int);
+    leer_contexto_fs(buffer, size, offset, contexto);
+}
+
+void* serializar_tag_file_con_contexto(const char* file_o, const char* tag_o, const char* file_d, const char* tag_d,
+                                       const contexto_fs_t* contexto, int* size) {
+    int size_base = 0;
+    void* base = serializar_tag_file(file_o, tag_o, file_d, tag_d, &size_base);
+    return agregar_contexto_fs(base, size_base, contexto, size);
+}
+
+void deserializar_tag_file_con_contexto(void* buffer, int size, char** file_o, char** tag_o, char** file_d, char** tag_d,
+                                        contexto_fs_t* contexto) {
+    deserializar_tag_file(buffer, file_o, tag_o, file_d, tag_d);
+    int offset = 0;
+    for (int i = 0; i < 4; i++) {
+        offset += largo_campo(buffer, offset);
+    }
+    leer_contexto_fs(buffer, size, offset, contexto);
+}
+
 // --- BLOCK_CONTENT (Storage -> Worker) ---
 // Payload: [data_size] [data]
 void* serializar_block_content(void* data, int data_size, int* size) {
@@ -380,6 +660,86 @@ void deserializar_query_finished_error(void* buffer, uint64_t* id, char** motivo
     memcpy(*motivo, buffer + offset, size_motivo);
 }
 
+// --- QUERY_RECHAZADA (Master -> QC) ---
+// Payload: [codigo_error] [retry_after_ms (int)] [size_motivo] [motivo]
+void* serializar_query_rechazada(error_code_t codigo_error, int retry_after_ms, const char* motivo, int* size) {
+    int size_motivo = strlen(motivo) + 1;
+    *size = sizeof(error_code_t) + sizeof(int) + sizeof(int) + size_motivo;
+
+    void* buffer = malloc(*size);
+    int offset = 0;
+
+    memcpy(buffer + offset, &codigo_error, sizeof(error_code_t)); offset += sizeof(error_code_t);
+    memcpy(buffer + offset, &retry_after_ms, sizeof(int)); offset += sizeof(int);
+    memcpy(buffer + offset, &size_motivo, sizeof(int)); offset += sizeof(int);
+    memcpy(buffer + offset, motivo, size_motivo);
+
+    return buffer;
+}
+
+void deserializar_query_rechazada(void* buffer, error_code_t* codigo_error, int* retry_after_ms, char** motivo) {
+    int offset = 0;
+    int size_motivo;
+
+    memcpy(codigo_error, buffer + offset, sizeof(error_code_t)); offset += sizeof(error_code_t);
+    memcpy(retry_after_ms, buffer + offset, sizeof(int)); offset += sizeof(int);
+    memcpy(&size_motivo, buffer + offset, sizeof(int)); offset += sizeof(int);
+    *motivo = malloc(size_motivo);
+    memcpy(*motivo, buffer + offset, size_motivo);
+}
+
+// --- HEARTBEAT_ACK (Worker -> Master) ---
+// Payload: [seq (uint64_t)] [query_id (uint64_t)] [pc (uint32_t)], los dos últimos opcionales
+void* serializar_heartbeat_ack(uint64_t seq, uint64_t query_id, uint32_t pc, int* size) {
+    *size = sizeof(uint64_t) + sizeof(uint64_t) + sizeof(uint32_t);
+
+    void* buffer = malloc(*size);
+    int offset = 0;
+
+    memcpy(buffer + offset, &seq, sizeof(uint64_t)); offset += sizeof(uint64_t);
+    memcpy(buffer + offset, &query_id, sizeof(uint64_t)); offset += sizeof(uint64_t);
+    memcpy(buffer + offset, &pc, sizeof(uint32_t));
+
+    return buffer;
+}
+
+void deserializar_heartbeat_ack(void* buffer, int size, uint64_t* seq, uint64_t* query_id, uint32_t* pc, bool* con_contexto) {
+    *seq = 0;
+    *query_id = 0;
+    *pc = 0;
+    *con_contexto = false;
+
+    if (size >= (int)sizeof(uint64_t)) {
+        memcpy(seq, buffer, sizeof(uint64_t));
+    }
+    if (size >= (int)(sizeof(uint64_t) + sizeof(uint64_t) + sizeof(uint32_t))) {
+        memcpy(query_id, buffer + sizeof(uint64_t), sizeof(uint64_t));
+        memcpy(pc, buffer + sizeof(uint64_t) + sizeof(uint64_t), sizeof(uint32_t));
+        *con_contexto = true;
+    }
+}
+
+// --- SCRIPT_FALTANTE (Worker -> Master) ---
+void* serializar_script_faltante(uint64_t id, const char* hash, int* size) {
+    *size = sizeof(uint64_t) + HASH_SCRIPT_SIZE;
+
+    void* buffer = malloc(*size);
+    int offset = 0;
+
+    memcpy(buffer + offset, &id, sizeof(uint64_t)); offset += sizeof(uint64_t);
+    memset(buffer + offset, 0, HASH_SCRIPT_SIZE);
+    strncpy(buffer + offset, hash, HASH_SCRIPT_SIZE - 1);
+
+    return buffer;
+}
+
+void deserializar_script_faltante(void* buffer, uint64_t* id, char** hash) {
+    memcpy(id, buffer, sizeof(uint64_t));
+    *hash = malloc(HASH_SCRIPT_SIZE);
+    memcpy(*hash, buffer + sizeof(uint64_t), HASH_SCRIPT_SIZE);
+    (*hash)[HASH_SCRIPT_SIZE - 1] = '\0';
+}
+
 // --- ERROR_RESPONSE (Respuesta de error genérica) ---
 void* serializar_error(error_code_t codigo_error, const char* mensaje, int* size) {
     int size_mensaje = strlen(mensaje) + 1;
@@ -5,12 +5,20 @@
 
 #include "comunicacion.h"
 #include <stdint.h>
+#include <stdbool.h>
+
+#define HASH_SCRIPT_SIZE 33   // MD5 en hexadecimal + '\0'
 
 
 // NEW_QUERY (QC -> Master)
 void* serializar_new_query(const char* path, int prioridad, int* size);
 void deserializar_new_query(void* buffer, char** path, int* prioridad);
 
+// NEW_QUERY con deadline relativo y costo estimado opcionales (campos al final del payload:
+// un Master que no los conoce los ignora). deadline_ms/costo_ms quedan en 0 si no vienen.
+void* serializar_new_query_con_deadline(const char* path, int prioridad, int deadline_ms, int costo_ms, int* size);
+void deserializar_new_query_con_deadline(void* buffer, int size, char** path, int* prioridad, int* deadline_ms, int* costo_ms);
+
 // NEW_QUERY_ACK y QUERY_FINISHED (Master -> QC y Worker -> Master)
 void* serializar_ack_con_id(uint64_t id, int* size);
 void deserializar_ack_con_id(void* buffer, uint64_t* id);
@@ -23,6 +31,28 @@ void deserializar_preemption_ack(void* buffer, uint32_t* pc);
 void* serializar_execute_query(uint64_t id, const char* path, uint32_t pc, int* size);
 void deserializar_execute_query(void* buffer, uint64_t* id, char** path, uint32_t* pc);
 
+// EXECUTE_QUERY extendido (solo para Workers que anunciaron la caché en el handshake).
+// hash vacío: el script no está en la caché del Master y se lee desde el path.
+// size_script == 0 con hash: el Worker ya tiene el script y script queda en NULL.
+// prioridad (NULL: no se envía) va al final solo si el Worker anunció CAPACIDAD_PRIORIDAD;
+// al deserializar queda en -1 si no vino.
+void* serializar_execute_query_con_script(uint64_t id, const char* path, uint32_t pc, const char* hash,
+                                          const void* script, int size_script, const int* prioridad, int* size);
+void deserializar_execute_query_con_script(void* buffer, int size, uint64_t* id, char** path, uint32_t* pc,
+                                           char** hash, void** script, int* size_script, int* prioridad);
+
+// EXECUTE_QUERY con prioridad (Workers con CAPACIDAD_PRIORIDAD sin CAPACIDAD_CACHE_SCRIPTS):
+// [EXECUTE_QUERY] [prioridad]. La prioridad es la actual de la query, para etiquetar sus
+// pedidos FS_*; -1 si no aplica (FIFO y EDF no ordenan por ese valor) o si no vino.
+void* serializar_execute_query_con_prioridad(uint64_t id, const char* path, uint32_t pc, int prioridad, int* size);
+void deserializar_execute_query_con_prioridad(void* buffer, int size, uint64_t* id, char** path, uint32_t* pc, int* prioridad);
+
+// HANDSHAKE_WORKER (Worker -> Master). Sin capacidades el payload es solo [id], como siempre.
+// capacidades es una combinación de CAPACIDAD_*; hashes son los scripts que el Worker ya tiene.
+void* serializar_handshake_worker(int id, int capacidades, char** hashes, int cantidad, int* size);
+// *capacidades queda en 0 para Workers viejos. *hashes es un array de *cantidad strings
+void deserializar_handshake_worker(void* buffer, int size, int* id, int* capacidades, char*** hashes, int* cantidad);
+
 // BLOCK_SIZE_RESPONSE (Storage -> Worker)
 void* serializar_respuesta_block_size(int block_size, int* size);
 void deserializar_respuesta_block_size(void* buffer, int* block_size);
@@ -47,6 +77,35 @@ void deserializar_read_block(void* buffer, char** file, char** tag, int* block_n
 void* serializar_tag_file(const char* file_o, const char* tag_o, const char* file_d, const char* tag_d, int* size);
 void deserializar_tag_file(void* buffer, char** file_o, char** tag_o, char** file_d, char** tag_d);
 
+// -- Contexto opcional de los FS_* (Worker -> Storage) --
+// Al final del payload: [query_id (uint64_t)] [prioridad (int)]. Es la query que hace el pedido y la
+// prioridad que le mandó el Master en EXECUTE_QUERY (-1 = sin prioridad), para que el Storage atienda
+// primero a las más prioritarias. Los deserializadores _con_contexto miran el largo del payload:
+// sin contexto dejan query_id en 0 y prioridad en -1, así un Worker viejo sigue funcionando.
+typedef struct {
+    uint64_t query_id;
+    int prioridad;
+} contexto_fs_t;
+
+void* serializar_file_tag_con_contexto(const char* file, const char* tag, const contexto_fs_t* contexto, int* size);
+void deserializar_file_tag_con_contexto(void* buffer, int size, char** file, char** tag, contexto_fs_t* contexto);
+
+void* serializar_truncate_con_contexto(const char* file, const char* tag, int new_size, const contexto_fs_t* contexto, int* size);
+void deserializar_truncate_con_contexto(void* buffer, int size, char** file, char** tag, int* new_size, contexto_fs_t* contexto);
+
+void* serializar_write_block_con_contexto(const char* file, const char* tag, int block_num, void* data, int data_size,
+                                          const contexto_fs_t* contexto, int* size);
+void deserializar_write_block_con_contexto(void* buffer, int size, char** file, char** tag, int* block_num,
+                                           void** data, int* data_size, contexto_fs_t* contexto);
+
+void* serializar_read_block_con_contexto(const char* file, const char* tag, int block_num, const contexto_fs_t* contexto, int* size);
+void deserializar_read_block_con_contexto(void* buffer, int size, char** file, char** tag, int* block_num, contexto_fs_t* contexto);
+
+void* serializar_tag_file_con_contexto(const char* file_o, const char* tag_o, const char* file_d, const char* tag_d,
+                                       const contexto_fs_t* contexto, int* size);
+void deserializar_tag_file_con_contexto(void* buffer, int size, char** file_o, char** tag_o, char** file_d, char** tag_d,
+                                        contexto_fs_t* contexto);
+
 // BLOCK_CONTENT (Storage -> Worker)
 void* serializar_block_content(void* data, int data_size, int* size);
 void deserializar_block_content(void* buffer, void** data, int* data_size);
@@ -55,10 +114,23 @@ void deserializar_block_content(void* buffer, void** data, int* data_size);
 void* serializar_read_result(uint64_t id, const char* origen, const char* contenido, int* size);
 void deserializar_read_result(void* buffer, uint64_t* id, char** origen, char** contenido);
 
+// HEARTBEAT_ACK (Worker -> Master): [seq] o, con una query en ejecución, [seq][query_id][pc].
+// con_contexto queda en false si el ack no trajo query_id/pc.
+void* serializar_heartbeat_ack(uint64_t seq, uint64_t query_id, uint32_t pc, int* size);
+void deserializar_heartbeat_ack(void* buffer, int size, uint64_t* seq, uint64_t* query_id, uint32_t* pc, bool* con_contexto);
+
+// SCRIPT_FALTANTE (Worker -> Master): llegó un EXECUTE_QUERY con un hash que el Worker no tiene
+void* serializar_script_faltante(uint64_t id, const char* hash, int* size);
+void deserializar_script_faltante(void* buffer, uint64_t* id, char** hash);
+
 // QUERY_FINISHED con motivo de error
 void* serializar_query_finished_error(uint64_t id, const char* motivo, int* size);
 void deserializar_query_finished_error(void* buffer, uint64_t* id, char** motivo);
 
+// QUERY_RECHAZADA (Master -> QC): READY lleno, reintentar pasados retry_after_ms
+void* serializar_query_rechazada(error_code_t codigo_error, int retry_after_ms, const char* motivo, int* size);
+void deserializar_query_rechazada(void* buffer, error_code_t* codigo_error, int* retry_after_ms, char** motivo);
+
 // ERROR_RESPONSE (Respuesta de error genérica)
 void* serializar_error(error_code_t codigo_error, const char* mensaje, int* size);
 void deserializar_error(void* buffer, error_code_t* codigo_error, char** mensaje);
@@ -8,6 +8,7 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <netdb.h>
 #include <commons/log.h>
 #include "serializacion.h"
@@ -34,6 +35,26 @@ static int common_getaddrinfo(t_log* logger, const char* host, const char* port,
 
 // --- Funciones Públicas ---
 
+int configurar_keepalive(int socket_fd, int user_timeout_ms) {
+    if (user_timeout_ms <= 0) return 0;
+
+    // Sin esto un peer que desaparece sin cerrar la conexión (host caído, cable cortado)
+    // recién se detecta con los timeouts por defecto del kernel, que son de minutos.
+    int yes = 1;
+    int idle = user_timeout_ms / 2000 > 0 ? user_timeout_ms / 2000 : 1;
+    int intervalo = user_timeout_ms / 6000 > 0 ? user_timeout_ms / 6000 : 1;
+    int probes = 3;
+
+    if (setsockopt(socket_fd, SOL_SOCKET, SO_KEEPALIVE, &yes, sizeof(yes)) == -1 ||
+        setsockopt(socket_fd, IPPROTO_TCP, TCP_KEEPIDLE, &idle, sizeof(idle)) == -1 ||
+        setsockopt(socket_fd, IPPROTO_TCP, TCP_KEEPINTVL, &intervalo, sizeof(intervalo)) == -1 ||
+        setsockopt(socket_fd, IPPROTO_TCP, TCP_KEEPCNT, &probes, sizeof(probes)) == -1 ||
+        setsockopt(socket_fd, IPPROTO_TCP, TCP_USER_TIMEOUT, &user_timeout_ms, sizeof(user_timeout_ms)) == -1) {
+        return -1;
+    }
+    return 0;
+}
+
 int iniciar_servidor(t_log* logger, const char* puerto) {
     struct addrinfo *server_info;
     
@@ -57,6 +78,11 @@ int iniciar_servidor(t_log* logger, const char* puerto) {
             close(socket_servidor);
             continue;
         }
+
+        // Los sockets aceptados heredan keepalive y TCP_USER_TIMEOUT del socket de escucha
+        if (configurar_keepalive(socket_servidor, TCP_USER_TIMEOUT_DEFAULT_MS) == -1) {
+            log_warning(logger, "No se pudo configurar keepalive en el socket de escucha");
+        }
         break;
     }
 
@@ -108,6 +134,10 @@ int crear_conexion(t_log* logger, const char* ip, const char* puerto) {
             close(socket_cliente);
             continue;
         }
+
+        if (configurar_keepalive(socket_cliente, TCP_USER_TIMEOUT_DEFAULT_MS) == -1) {
+            log_warning(logger, "No se pudo configurar keepalive en la conexión a %s:%s", ip, puerto);
+        }
         break;
     }
 
@@ -135,7 +165,8 @@ int enviar_paquete(int socket_fd, op_code codigo, void* payload, int size) {
     memcpy(buffer + sizeof(op_code), &size, sizeof(int));
     if (size > 0) memcpy(buffer + header_size, payload, size);
 
-    ssize_t bytes_sent = send(socket_fd, buffer, header_size + size, 0);
+    // MSG_NOSIGNAL: enviar a un socket cerrado (o con shutdown) devuelve EPIPE en lugar de matar el proceso con SIGPIPE
+    ssize_t bytes_sent = send(socket_fd, buffer, header_size + size, MSG_NOSIGNAL);
     free(buffer);
     
     return (bytes_sent == header_size + size) ? 0 : -1;
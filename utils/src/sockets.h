@@ -8,6 +8,9 @@
 #include "comunicacion.h"
 #include <commons/log.h>
 
+// Tiempo máximo (ms) que un envío puede quedar sin confirmar antes de dar la conexión por caída
+#define TCP_USER_TIMEOUT_DEFAULT_MS 10000
+
 // Funciones de Cliente
 int crear_conexion(t_log* logger, const char* ip, const char* puerto);
 void liberar_conexion(int socket_fd);
@@ -16,6 +19,9 @@ void liberar_conexion(int socket_fd);
 int iniciar_servidor(t_log* logger, const char* puerto);
 int esperar_cliente(t_log* logger, int socket_servidor);
 
+// Keepalive de TCP + TCP_USER_TIMEOUT (user_timeout_ms <= 0 deja los valores del kernel)
+int configurar_keepalive(int socket_fd, int user_timeout_ms);
+
 // Funciones de Comunicación 
 int enviar_paquete(int socket, op_code codigo, void* payload, int size);
 void* recibir_payload(int socket, op_code* codigo, int* size);